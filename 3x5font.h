@@ -1,6 +1,6 @@
 #include <avr/pgmspace.h>
 // copied from http://heim.ifi.uio.no/haakoh/avr/a
-const int font_count = 10;
+const int font3x5_count = 10;
 unsigned char PROGMEM font3x5[10][3] = 
 {{0x1F,0x11,0x1F}
 ,{0x9,0x1F,0x1}
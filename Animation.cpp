@@ -0,0 +1,173 @@
+/*
+	MatrixDisplay Library 2.0
+	Author: Miles Burton, www.milesburton.com/
+	Need a 16x24 display? Check out www.mnethardware.co.uk
+	Copyright (c) 2010 Miles Burton All Rights Reserved
+
+	This library is free software; you can redistribute it and/or
+	modify it under the terms of the GNU Lesser General Public
+	License as published by the Free Software Foundation; either
+	version 2.1 of the License, or (at your option) any later version.
+
+	This library is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+	Lesser General Public License for more details.
+
+	You should have received a copy of the GNU Lesser General Public
+	License along with this library; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+
+#include "Animation.h"
+
+///////////////////////////////////////////////////////////////////////////////
+//  CTORS & DTOR
+//
+Animation::Animation(MatrixDisplay* _disp)
+	: disp(_disp)
+	, pData(NULL)
+	, pNext(NULL)
+	, columns(0)
+	, frameCount(0)
+	, loopFrame(ANIM_NO_LOOP)
+	, loopOffset(0)
+	, frame(0)
+	, nextFrame(0)
+	, frameStart(0)
+	, frameDelay(0)
+	, playing(false)
+{
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//  PUBLIC FUNCTIONS
+//
+void Animation::play(const uint8_t* data)
+{
+	pData = data;
+	columns = pgm_read_word(data);
+	frameCount = pgm_read_word(data + 2);
+	loopFrame = pgm_read_word(data + 4);
+	loopOffset = pgm_read_word(data + 6);
+	
+	// The first frame is encoded against a blank display
+	for(uint16_t column=0; column<columns; ++column) writeColumn(column, 0);
+	
+	pNext = data + ANIM_HEADER_SIZE;
+	frame = 0;
+	nextFrame = 0;
+	frameDelay = 0;
+	playing = frameCount > 0;
+}
+
+void Animation::stop()
+{
+	playing = false;
+}
+
+bool Animation::isPlaying()
+{
+	return playing;
+}
+
+bool Animation::update()
+{
+	return update(millis());
+}
+
+bool Animation::update(unsigned long now)
+{
+	if(!playing) return false;
+	if(nextFrame > 0 && now - frameStart < frameDelay) return false;
+	
+	if(nextFrame >= frameCount && loopFrame == ANIM_NO_LOOP)
+	{
+		// Last frame has had its time
+		playing = false;
+		return false;
+	}
+	
+	const uint8_t* pFrame = pNext;
+	frameDelay = pgm_read_word(pFrame);
+	pNext = decodeFrame(pFrame + 2);
+	frameStart = now;
+	
+	if(nextFrame >= frameCount)
+	{
+		// The loop frame, carry on from the one after loopFrame
+		frame = loopFrame;
+		pNext = pData + loopOffset;
+	}
+	else
+	{
+		frame = nextFrame;
+	}
+	nextFrame = frame + 1;
+	
+	return true;
+}
+
+uint16_t Animation::getFrame()
+{
+	return frame;
+}
+
+uint16_t Animation::getFrameCount()
+{
+	return frameCount;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//  PRIVATE FUNCTIONS
+//
+// Apply one frame's ops to the back buffer, returns the start of the following frame
+const uint8_t* Animation::decodeFrame(const uint8_t* pOp)
+{
+	uint16_t column = 0;
+	
+	for(;;)
+	{
+		uint8_t op = pgm_read_byte(pOp++);
+		if(op == ANIM_OP_END) break;
+		
+		if(!(op & ANIM_OP_LITERAL))
+		{
+			column += op; // Unchanged
+			continue;
+		}
+		
+		uint8_t count = op & ANIM_RUN_MASK;
+		if((op & ANIM_OP_REPEAT) == ANIM_OP_REPEAT)
+		{
+			uint8_t value = pgm_read_byte(pOp++);
+			while(count--) writeColumn(column++, value);
+		}
+		else
+		{
+			while(count--) writeColumn(column++, pgm_read_byte(pOp++));
+		}
+	}
+	
+	return pOp;
+}
+
+void Animation::writeColumn(uint16_t column, uint8_t value)
+{
+	uint8_t bufferSize = disp->getDisplayWidth() * disp->getPlaneCount();
+	uint8_t dispNum = column / bufferSize;
+	if(dispNum >= disp->getDisplayCount()) return;
+	
+	uint8_t* pBuffer = disp->getBuffer(dispNum);
+	if(!pBuffer) return; // Pass-through display, nothing to draw into
+	
+	uint8_t x = column - (dispNum * bufferSize);
+	uint8_t* pCol = pBuffer + x;
+	if(*pCol == value) return;
+	
+	*pCol = value;
+	disp->markDirty(dispNum, x);
+}
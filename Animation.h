@@ -0,0 +1,98 @@
+/*
+	MatrixDisplay Library 2.0
+	Author: Miles Burton, www.milesburton.com/
+	Need a 16x24 display? Check out www.mnethardware.co.uk
+	Copyright (c) 2010 Miles Burton All Rights Reserved
+
+	This library is free software; you can redistribute it and/or
+	modify it under the terms of the GNU Lesser General Public
+	License as published by the Free Software Foundation; either
+	version 2.1 of the License, or (at your option) any later version.
+
+	This library is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+	Lesser General Public License for more details.
+
+	You should have received a copy of the GNU Lesser General Public
+	License along with this library; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#ifndef ANIMATION_GUARD
+#define ANIMATION_GUARD
+
+#include <inttypes.h>
+#include <string.h>
+#include <stdlib.h>
+#include <avr/pgmspace.h>
+#include <MatrixDisplay.h>
+
+/*
+Plays back compressed animations straight out of flash (build the data with tools/animpack).
+
+Frames are stored as deltas against the previous frame, so only the changed columns are decoded
+into the back buffer and flagged dirty, nothing else is kept in RAM besides a read pointer. The
+timing comes from the data: every frame carries its own delay and the stream can loop back to any
+frame.
+
+Layout (all 16 bit values little endian):
+	header	columns, frameCount, loopFrame (ANIM_NO_LOOP = play once), loopOffset (byte offset of the frame after loopFrame)
+	frame	delay (ms), then ops until ANIM_OP_END
+	        0x01-0x7F      skip n columns
+	        0x80 | n       n literal columns follow (n = 1-63)
+	        0xC0 | n       the next byte repeats for n columns (n = 1-63)
+A looping stream has one extra frame after the last one, loopFrame encoded against the last frame.
+
+Columns are back buffer bytes across the chain, display 0 starts at column 0. On bi-colour panels
+a display's green plane is followed by its red plane.
+*/
+
+#define ANIM_NO_LOOP     0xFFFF
+#define ANIM_HEADER_SIZE 8
+
+#define ANIM_OP_END      0x00
+#define ANIM_OP_LITERAL  0x80
+#define ANIM_OP_REPEAT   0xC0
+#define ANIM_RUN_MASK    0x3F
+
+class Animation
+{
+private:
+	MatrixDisplay* disp;
+	
+	const uint8_t* pData; // PROGMEM
+	const uint8_t* pNext; // Next frame to decode
+	uint16_t columns;
+	uint16_t frameCount;
+	uint16_t loopFrame;
+	uint16_t loopOffset;
+	
+	uint16_t frame; // Frame on show
+	uint16_t nextFrame; // frameCount = the loop frame at the end of the stream
+	unsigned long frameStart;
+	uint16_t frameDelay;
+	bool playing;
+	
+	const uint8_t* decodeFrame(const uint8_t* pFrame);
+	void writeColumn(uint16_t column, uint8_t value);
+	
+public:	
+	// Constructor
+	Animation(MatrixDisplay* disp);
+	
+	// Start playing data (PROGMEM) from its first frame, the animation's columns are cleared first
+	void play(const uint8_t* data);
+	void stop();
+	bool isPlaying();
+	
+	// Call from loop(), decodes the next frame once the current one's delay is up.
+	// Returns true when a frame was decoded, call disp.syncDirty() to show it
+	bool update();
+	bool update(unsigned long now); // now in milliseconds
+	
+	uint16_t getFrame();
+	uint16_t getFrameCount();
+};
+
+#endif
@@ -21,6 +21,15 @@
 
 
 #include <DisplayToolbox.h>
+
+// Perceived brightness (0-255 in steps of 4) to HT1632 PWM level, gamma 2.2
+static const uint8_t PROGMEM gammaPwm[64] = {
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1, 1,
+	1, 1, 1, 1, 1, 1, 1, 2, 2, 2, 2, 2, 3, 3, 3, 3,
+	3, 4, 4, 4, 4, 5, 5, 5, 6, 6, 6, 6, 7, 7, 8, 8,
+	8, 9, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13, 13, 14, 14, 15
+};
+
 ///////////////////////////////////////////////////////////////////////////////
 //  CTORS & DTOR
 //
@@ -29,6 +38,9 @@
 	{
 		// Take reference to display
 		disp = _disp;
+		drawColour = COLOUR_GREEN;
+		memset(sprites, 0, sizeof(sprites));
+		memset(fades, 0, sizeof(fades));
 	}
 
 	DisplayToolbox::~DisplayToolbox()
@@ -37,41 +49,198 @@
 	}
 	
 	
-// y, y radius, color
-// Shamelessly taken from http://actionsnippet.com/?p=492
-void DisplayToolbox::drawCircle(uint8_t xp,uint8_t  yp, uint8_t radius, uint8_t col)
-{
-  int8_t  balance = 0;
-  int8_t xoff = 0;
-  int8_t yoff = 0;
-  xoff=0;
-  yoff=radius;
-  balance=- radius;
-  while (xoff <= yoff) {
-    setPixel(xp+xoff, yp+yoff, col);
-    setPixel(xp-xoff, yp+yoff, col);
-    setPixel(xp-xoff, yp-yoff, col);
-    setPixel(xp+xoff, yp-yoff, col);
-    setPixel(xp+yoff, yp+xoff, col);
-    setPixel(xp-yoff, yp+xoff, col);
-    setPixel(xp-yoff, yp-xoff, col);
-    setPixel(xp+yoff, yp-xoff, col);
-    if ((balance += xoff++ + xoff)>= 0) 
-    {
-      balance-=--yoff+yoff;
-    }
-  }
+// Rows y0 to y1 (inclusive) of a column as a bit mask, clipped to the display
+static uint8_t spanMask(int y0, int y1)
+{
+	if(y0 < 0) y0 = 0;
+	if(y1 > 7) y1 = 7;
+	if(y0 > y1) return 0;
+	return (0xFF << y0) & (0xFF >> (7 - y1));
+}
+
+// Apply a raster op to one column of the virtual display
+// pattern - the bits the primitive draws, box - the area it covers (used by ROP_INVERT and ROP_COPY)
+void DisplayToolbox::applyColumn(int x, uint8_t pattern, uint8_t box, uint8_t op)
+{
+	if(x < 0) return;
+	int dispNum = calcDispNum(x); // Updates x as well!
+	if(dispNum >= disp->getDisplayCount()) return; // Don't write to a non-existent display
+	
+	uint8_t* pCol = disp->getBuffer(dispNum);
+	if(!pCol) return; // Pass-through display, nothing to draw into
+	pCol += x;
+	uint8_t planes = disp->getPlaneCount();
+	uint8_t planeWidth = disp->getDisplayWidth();
+	
+	// Mono panels have one plane. On bi-colour panels the drawing colour picks the planes drawn into,
+	// the other plane is only cleared (ROP_CLEAR, or the box of ROP_COPY)
+	for(uint8_t plane=0; plane<planes; ++plane, pCol += planeWidth)
+	{
+		bool inColour = planes == 1 || (drawColour & (1 << plane));
+		switch(op)
+		{
+		case ROP_CLEAR:  *pCol &= ~pattern; break;
+		case ROP_SET:    if(inColour) *pCol |= pattern; break;
+		case ROP_XOR:    if(inColour) *pCol ^= pattern; break;
+		case ROP_INVERT: if(inColour) *pCol ^= box; break;
+		case ROP_COPY:   *pCol = (*pCol & ~box) | (inColour ? (pattern & box) : 0); break;
+		}
+		disp->markDirty(dispNum, x + (plane * planeWidth));
+	}
+}
+
+// Colour used by the drawing primitives on bi-colour panels (COLOUR_GREEN, COLOUR_RED or COLOUR_ORANGE)
+void DisplayToolbox::setColour(uint8_t colour)
+{
+	drawColour = colour;
+}
+
+// sin() of 0-90 degrees scaled to 255
+static const uint8_t PROGMEM sineTable[91] = {
+	0, 4, 9, 13, 18, 22, 27, 31, 35, 40, 44, 49, 53, 57, 62, 66,
+	70, 75, 79, 83, 87, 91, 96, 100, 104, 108, 112, 116, 120, 124, 127, 131,
+	135, 139, 143, 146, 150, 153, 157, 160, 164, 167, 171, 174, 177, 180, 183, 186,
+	190, 192, 195, 198, 201, 204, 206, 209, 211, 214, 216, 219, 221, 223, 225, 227,
+	229, 231, 233, 235, 236, 238, 240, 241, 243, 244, 245, 246, 247, 248, 249, 250,
+	251, 252, 253, 253, 254, 254, 254, 255, 255, 255, 255
+};
+
+// sin() of any angle in degrees, scaled to +-255
+int16_t DisplayToolbox::sin8(int angle)
+{
+	angle %= 360;
+	if(angle < 0) angle += 360;
+	
+	if(angle <= 90) return pgm_read_byte(&sineTable[angle]);
+	if(angle <= 180) return pgm_read_byte(&sineTable[180 - angle]);
+	if(angle <= 270) return -(int16_t)pgm_read_byte(&sineTable[angle - 180]);
+	return -(int16_t)pgm_read_byte(&sineTable[360 - angle]);
+}
+
+int16_t DisplayToolbox::cos8(int angle)
+{
+	return sin8(angle + 90);
+}
+
+// Is the point (dx, dy) from the centre inside the sector? Cross products, no trig per pixel
+static bool inSector(long dx, long dy, int16_t ax, int16_t ay, int16_t bx, int16_t by, bool wide)
+{
+	bool afterStart = (ax * dy - ay * dx) >= 0;
+	bool beforeEnd = (dx * by - dy * bx) >= 0;
+	return wide ? (afterStart || beforeEnd) : (afterStart && beforeEnd);
+}
+
+// Ellipses, circles and arcs all come through here. Each column's outline (or fill) is a vertical span,
+// found incrementally from the column's height h (h*h*rx*rx + dx*dx*ry*ry <= rx*rx*ry*ry + rx*ry*min(rx, ry)),
+// and written with one byte op. Radii are capped at 127 so the sums fit in 32 bits.
+void DisplayToolbox::ellipseColumns(int xp, int yp, uint8_t rx, uint8_t ry, uint8_t op, bool filled, const Sector* sector)
+{
+	if(rx > 127) rx = 127;
+	if(ry > 127) ry = 127;
+	
+	unsigned long rx2 = (unsigned long)rx * rx;
+	unsigned long ry2 = (unsigned long)ry * ry;
+	unsigned long limit = rx2 * ry2 + (unsigned long)rx * ry * (rx < ry ? rx : ry);
+	int h = ry;
+	
+	for(int dx = 0; dx <= rx; ++dx)
+	{
+		while(h > 0 && (unsigned long)h * h * rx2 + (unsigned long)dx * dx * ry2 > limit) --h;
+		
+		// Next column's height, the outline fills the gap between the two
+		int inner = 0;
+		if(!filled && dx < rx)
+		{
+			int next = h;
+			while(next >= 0 && (unsigned long)next * next * rx2 + (unsigned long)(dx + 1) * (dx + 1) * ry2 > limit) --next;
+			inner = next + 1 > h ? h : next + 1;
+		}
+		
+		for(int8_t side = 1; side >= -1; side -= 2)
+		{
+			if(side < 0 && dx == 0) break; // Centre column only once
+			
+			uint8_t mask = 0;
+			if(sector == NULL)
+			{
+				mask = filled ? spanMask(yp - h, yp + h) : (spanMask(yp - h, yp - inner) | spanMask(yp + inner, yp + h));
+			}
+			else
+			{
+				// Arcs, test the (at most 8) visible rows of the span against the sector
+				for(int y = (yp - h < 0 ? 0 : yp - h); y <= yp + h && y <= 7; ++y)
+				{
+					int dy = y - yp;
+					if(!filled && dy > -inner && dy < inner) continue;
+					if(inSector(side * dx, dy, sector->ax, sector->ay, sector->bx, sector->by, sector->wide)) mask |= (1 << y);
+				}
+			}
+			
+			if(mask) applyColumn(xp + side * dx, mask, mask, op);
+		}
+	}
+}
+
+void DisplayToolbox::drawCircle(int xp, int yp, uint8_t radius, uint8_t op)
+{
+	ellipseColumns(xp, yp, radius, radius, op, false, NULL);
+}
+
+void DisplayToolbox::fillCircle(int xp, int yp, uint8_t radius, uint8_t op)
+{
+	ellipseColumns(xp, yp, radius, radius, op, true, NULL);
+}
+
+void DisplayToolbox::drawEllipse(int xp, int yp, uint8_t rx, uint8_t ry, uint8_t op)
+{
+	ellipseColumns(xp, yp, rx, ry, op, false, NULL);
+}
+
+void DisplayToolbox::fillEllipse(int xp, int yp, uint8_t rx, uint8_t ry, uint8_t op)
+{
+	ellipseColumns(xp, yp, rx, ry, op, true, NULL);
+}
+
+// Angles in degrees, 0 is 3 o'clock and they run clockwise (y points down)
+void DisplayToolbox::drawArc(int xp, int yp, uint8_t radius, int startAngle, int endAngle, uint8_t op)
+{
+	Sector sector = makeSector(startAngle, endAngle);
+	bool full = (endAngle - startAngle) >= 360 || (startAngle - endAngle) >= 360;
+	ellipseColumns(xp, yp, radius, radius, op, false, full ? NULL : &sector);
+}
+
+// Pie slice
+void DisplayToolbox::fillArc(int xp, int yp, uint8_t radius, int startAngle, int endAngle, uint8_t op)
+{
+	Sector sector = makeSector(startAngle, endAngle);
+	bool full = (endAngle - startAngle) >= 360 || (startAngle - endAngle) >= 360;
+	ellipseColumns(xp, yp, radius, radius, op, true, full ? NULL : &sector);
+}
+
+DisplayToolbox::Sector DisplayToolbox::makeSector(int startAngle, int endAngle)
+{
+	int sweep = (endAngle - startAngle) % 360;
+	if(sweep < 0) sweep += 360;
+	
+	Sector sector;
+	sector.ax = cos8(startAngle);
+	sector.ay = sin8(startAngle);
+	sector.bx = cos8(endAngle);
+	sector.by = sin8(endAngle);
+	sector.wide = sweep > 180;
+	return sector;
 }
 
 
 // Bresenham's line function
-void DisplayToolbox::drawLine(uint8_t x1, uint8_t y1, uint8_t x2, uint8_t y2, uint8_t val )
+// Pixels are gathered into a column mask and written once per column
+void DisplayToolbox::drawLine(int x1, int y1, int x2, int y2, uint8_t val )
 {
-  char deltax = abs(x2 - x1);        // The difference between the x's
-  char deltay = abs(y2 - y1);        // The difference between the y's
-  char x = x1;                       // Start x off at the first pixel
-  char y = y1;                       // Start y off at the first pixel
-  char xinc1, xinc2, yinc1, yinc2, den, num, numadd, numpixels, curpixel;
+  int deltax = abs(x2 - x1);        // The difference between the x's
+  int deltay = abs(y2 - y1);        // The difference between the y's
+  int x = x1;                       // Start x off at the first pixel
+  int y = y1;                       // Start y off at the first pixel
+  int xinc1, xinc2, yinc1, yinc2, den, num, numadd, numpixels, curpixel;
 
   if (x2 >= x1) {                // The x-values are increasing
     xinc1 = 1;
@@ -112,9 +281,17 @@ void DisplayToolbox::drawLine(uint8_t x1, uint8_t y1, uint8_t x2, uint8_t y2, ui
     numpixels = deltay;         // There are more y-values than x-values
   }
 
+  int column = x;
+  uint8_t mask = 0;
   for (curpixel = 0; curpixel <= numpixels; curpixel++)
   {
-    setPixel(x, y, val);             // Draw the current pixel
+    if (x != column)            // Moved to a new column, write out the last one
+    {
+      applyColumn(column, mask, mask, val);
+      column = x;
+      mask = 0;
+    }
+    mask |= spanMask(y, y);     // Add the current pixel
     num += numadd;              // Increase the numerator by the top of the fraction
     if (num >= den)             // Check if numerator >= denominator
     {
@@ -125,6 +302,7 @@ void DisplayToolbox::drawLine(uint8_t x1, uint8_t y1, uint8_t x2, uint8_t y2, ui
     x += xinc2;                 // Change the x as appropriate
     y += yinc2;                 // Change the y as appropriate
   }
+  applyColumn(column, mask, mask, val);
 }
 
 // setPixelting function (adds support for multiple displays)
@@ -134,11 +312,21 @@ void DisplayToolbox::setPixel(int x, int y, int val, bool paint)
   // Display Number
   // X Cordinate
   // Y Cordinate
-  // Value (either on or off, 1, 0)
+  // Value (ROP_CLEAR/ROP_SET, or ROP_XOR/ROP_INVERT to flip it)
   // Do you want to write this change straight to the display? (yes: slower)
   //disp->setPixel(calcDispNum(x), x, y, val, paint);  
+  if (x < 0 || y < 0 || y > 7) return;
   int dispNum = calcDispNum(x);                       // Updates x as well!
   if (dispNum >= disp->getDisplayCount()) return; // Don't write to a non-existent display
+  if (!disp->getBuffer(dispNum)) return; // Pass-through display, nothing to draw into
+  if (disp->getPlaneCount() > 1)
+  {
+    // Bi-colour, the raster op works on the drawing colour
+    if (val == ROP_XOR || val == ROP_INVERT) val = disp->getPixel(dispNum, x, y) ^ drawColour;
+    else if (val != ROP_CLEAR) val = drawColour;
+  }
+  else if (val == ROP_XOR || val == ROP_INVERT) val = (disp->getBuffer(dispNum)[x] & (1 << y)) ? 0 : 1; // Flip it
+  else if (val == ROP_COPY) val = 1;
   disp->setPixel(dispNum, x, y, val, paint); 
 }
 
@@ -146,7 +334,10 @@ void DisplayToolbox::setPixel(int x, int y, int val, bool paint)
 // fromShadow - Retrieve from a secondary buffer. 
 uint8_t DisplayToolbox::getPixel(int x, int y, bool fromShadow)
 {
-  return disp->getPixel(calcDispNum(x), x, y, fromShadow);   
+  if (x < 0 || y < 0 || y > 7) return 0;
+  uint8_t dispNum = calcDispNum(x);                  // Updates x as well, so it can't share a statement with x
+  if (dispNum >= disp->getDisplayCount()) return 0; // Off the end of the chain
+  return disp->getPixel(dispNum, x, y, fromShadow);   
 }
 
 // Calculate which display x resides and adjust x so it's within the bounds of one display
@@ -163,16 +354,411 @@ uint8_t DisplayToolbox::calcDispNum(int& x)
 
 void DisplayToolbox::setBrightness(uint8_t pwmValue)
 {
-	for(int dispNum=0; dispNum<disp->getDisplayCount(); ++dispNum) disp->setBrightness(dispNum, pwmValue); 
+	disp->setGroupBrightness(ALL_PANELS, pwmValue);
+}
+
+
+
+// Covers _x to _x+width and _y to _y+height (inclusive). Each column is written once
+void DisplayToolbox::drawRectangle(int _x, int _y, uint8_t width, uint8_t height, uint8_t colour, bool filled)
+{
+	uint8_t sides = spanMask(_y, _y + height); // Left side, right side or the whole column when filled
+	uint8_t edges = filled ? sides : (spanMask(_y, _y) | spanMask(_y + height, _y + height)); // Top and bottom of box
+	
+	for(int x = _x; x <= _x + width; ++x)
+	{
+		uint8_t mask = (x == _x || x == _x + width) ? sides : edges;
+		applyColumn(x, mask, mask, colour);
+	}
+}
+
+// Blit a column packed bitmap (bit 0 = top row, up to 8 rows). The box is the bitmap's full height
+void DisplayToolbox::drawBitmap(int x, int y, const uint8_t* bitmap, uint8_t width, uint8_t height, uint8_t op, bool inProgmem)
+{
+	if(y <= -8 || y >= 8) return;
+	
+	uint8_t box = (height >= 8) ? 0xFF : (1 << height) - 1;
+	box = y >= 0 ? (box << y) : (box >> -y);
+	
+	for(uint8_t col=0; col<width; ++col)
+	{
+		uint8_t bits = inProgmem ? pgm_read_byte(bitmap + col) : bitmap[col];
+		bits = y >= 0 ? (bits << y) : (bits >> -y);
+		applyColumn(x + col, bits & box, box, op);
+	}
 }
 
 
+// Inverse mapping, every destination pixel in the bounding box looks up its source pixel.
+// Per pixel it's two adds and a compare, no multiplies
+void DisplayToolbox::drawAffine(int cx, int cy, const uint8_t* bitmap, uint8_t width, uint8_t height,
+								int16_t dudx, int16_t dvdx, int16_t dudy, int16_t dvdy, uint8_t op, bool inProgmem)
+{
+	if(height > 8) height = 8;
+	
+	// The bitmap's half diagonal is under (width + height) / 2, scaled by the largest step.
+	// Small steps (big zoom) reach far, so work it out in 32 bits and clamp it to the chain
+	int32_t stepX = labs(dudx) > labs(dvdx) ? labs(dudx) : labs(dvdx);
+	int32_t stepY = labs(dudy) > labs(dvdy) ? labs(dudy) : labs(dvdy);
+	int32_t step = stepX < stepY ? stepX : stepY;
+	if(step == 0) return;
+	int chainWidth = disp->getDisplayWidth() * disp->getDisplayCount();
+	int32_t reach = (((int32_t)width + height) << 7) / step + 1;
+	if(reach > chainWidth) reach = chainWidth;
+	
+	// Clip the box to the chain and the 8 rows
+	int x0 = cx - reach < 0 ? 0 : cx - reach;
+	int x1 = cx + reach >= chainWidth ? chainWidth - 1 : cx + reach;
+	int y0 = cy - reach < 0 ? 0 : cy - reach;
+	int y1 = cy + reach > 7 ? 7 : cy + reach;
+	if(x0 > x1 || y0 > y1) return;
+	
+	// Source position of (x0, y0), the bitmap's centre sits on (cx, cy)
+	long uRow = ((long)width << 7) + (long)dudx * (x0 - cx) + (long)dudy * (y0 - cy);
+	long vRow = ((long)height << 7) + (long)dvdx * (x0 - cx) + (long)dvdy * (y0 - cy);
+	long uLimit = (long)width << 8;
+	long vLimit = (long)height << 8;
+	
+	for(int x = x0; x <= x1; ++x, uRow += dudx, vRow += dvdx)
+	{
+		uint8_t pattern = 0;
+		uint8_t box = 0;
+		long u = uRow;
+		long v = vRow;
+		
+		for(int y = y0; y <= y1; ++y, u += dudy, v += dvdy)
+		{
+			if(u < 0 || v < 0 || u >= uLimit || v >= vLimit) continue;
+			
+			uint8_t col = u >> 8;
+			uint8_t bits = inProgmem ? pgm_read_byte(bitmap + col) : bitmap[col];
+			box |= 1 << y;
+			if(bits & (1 << (v >> 8))) pattern |= 1 << y;
+		}
+		
+		if(box) applyColumn(x, pattern, box, op);
+	}
+}
 
-void DisplayToolbox::drawRectangle(uint8_t _x, uint8_t _y, uint8_t width, uint8_t height, uint8_t colour, bool filled)
+// Steps for rotating by angle and zooming by scale, the inverse of the transform being drawn
+void DisplayToolbox::drawRotated(int cx, int cy, const uint8_t* bitmap, uint8_t width, uint8_t height,
+								 int angle, uint16_t scale, uint8_t op, bool inProgmem)
 {
-	drawLine(_x, _y, _x, _y+height, colour); // Left side of box
-	drawLine(_x+width, _y, _x+width, _y+height, colour); // Right side of box
+	if(scale == 0) return;
 	
-	drawLine(_x, _y, _x+width, _y, colour); // top of box
-	drawLine(_x, _y+height, _x+width, _y+height, colour); // bottom of box
+	// sin8/cos8 are scaled to 255, the steps to 256 / scale. Below scale 3 they no longer fit
+	// drawAffine's 8.8 steps, clamp them (the bitmap is a dot or two by then anyway)
+	long c = ((long)cos8(angle) << 16) / (255L * scale);
+	long s = ((long)sin8(angle) << 16) / (255L * scale);
+	if(c > 32767) c = 32767; else if(c < -32767) c = -32767;
+	if(s > 32767) s = 32767; else if(s < -32767) s = -32767;
+	
+	drawAffine(cx, cy, bitmap, width, height, c, -s, s, c, op, inProgmem);
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//  TEXT
+//
+uint8_t DisplayToolbox::drawChar(int x, int y, char c, const PackedFont& font, uint8_t op)
+{
+	uint8_t ch = (uint8_t)c;
+	if(ch < font.firstChar || ch > font.lastChar) return 0;
+	ch -= font.firstChar;
+	
+	uint8_t glyphWidth = pgm_read_byte(font.widths + ch);
+	drawBitmap(x, y, font.columns + pgm_read_word(font.offsets + ch), glyphWidth, font.height, op, true);
+	return glyphWidth;
+}
+
+int DisplayToolbox::drawString(int x, int y, const char* str, const PackedFont& font, uint8_t op)
+{
+	int start = x;
+	while(*str)
+	{
+		x += drawChar(x, y, *str++, font, op);
+		if(*str) x += font.spacing;
+	}
+	return x - start;
+}
+
+int DisplayToolbox::getStringWidth(const char* str, const PackedFont& font)
+{
+	int width = 0;
+	while(*str)
+	{
+		uint8_t ch = (uint8_t)*str++;
+		if(ch >= font.firstChar && ch <= font.lastChar) width += pgm_read_byte(font.widths + ch - font.firstChar);
+		if(*str) width += font.spacing;
+	}
+	return width;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//  FADES
+//
+bool DisplayToolbox::fadeBrightness(uint32_t panelMask, uint8_t fromLevel, uint8_t toLevel, unsigned long duration)
+{
+	int8_t slot = -1;
+	for(uint8_t i=0; i<TOOLBOX_MAX_FADES; ++i)
+	{
+		// Take the displays out of any fade already running on them
+		fades[i].panels &= ~panelMask;
+		if(fades[i].panels == 0 && slot < 0) slot = i;
+	}
+	if(slot < 0) return false;
+	
+	Fade& f = fades[slot];
+	f.panels = panelMask;
+	f.fromLevel = fromLevel;
+	f.toLevel = toLevel;
+	f.start = millis();
+	f.duration = duration;
+	f.lastPwm = 0xFF; // Force the first step out
+	return true;
+}
+
+bool DisplayToolbox::updateFades()
+{
+	bool fading = false;
+	unsigned long now = millis();
+	
+	for(uint8_t i=0; i<TOOLBOX_MAX_FADES; ++i)
+	{
+		Fade& f = fades[i];
+		if(f.panels == 0) continue;
+		
+		unsigned long elapsed = now - f.start;
+		uint8_t level = f.toLevel;
+		if(elapsed < f.duration)
+		{
+			int16_t delta = (int16_t)f.toLevel - f.fromLevel;
+			level = f.fromLevel + (int16_t)((delta * (long)elapsed) / (long)f.duration);
+		}
+		
+		uint8_t pwm = pgm_read_byte(&gammaPwm[level >> 2]);
+		if(pwm != f.lastPwm)
+		{
+			disp->setGroupBrightness(f.panels, pwm);
+			f.lastPwm = pwm;
+		}
+		
+		if(elapsed >= f.duration) f.panels = 0; // Done
+		else fading = true;
+	}
+	return fading;
+}
+
+void DisplayToolbox::stopFades()
+{
+	memset(fades, 0, sizeof(fades));
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//  SPRITES
+//
+int8_t DisplayToolbox::addSprite(const uint8_t* bitmap, const uint8_t* mask, uint8_t width, bool inProgmem, uint8_t z)
+{
+	for(int8_t id=0; id<TOOLBOX_MAX_SPRITES; ++id)
+	{
+		// A removed sprite keeps its slot until the next update has erased it
+		if(sprites[id].flags & (SPRITE_USED | SPRITE_DRAWN)) continue;
+		
+		Sprite& s = sprites[id];
+		s.bitmap = bitmap;
+		s.mask = mask;
+		s.width = width;
+		s.z = z;
+		s.x = 0;
+		s.y = 0;
+		s.flags = SPRITE_USED | SPRITE_VISIBLE | SPRITE_CHANGED | (inProgmem ? SPRITE_PROGMEM : 0);
+		return id;
+	}
+	return -1; // Pool is full
+}
+
+void DisplayToolbox::removeSprite(int8_t id)
+{
+	// Hide it, the next update will restore the background and free the slot
+	setSpriteVisible(id, false);
+	sprites[id].flags &= ~SPRITE_USED;
+}
+
+void DisplayToolbox::moveSprite(int8_t id, int16_t x, int8_t y)
+{
+	Sprite& s = sprites[id];
+	if(s.x == x && s.y == y) return;
+	s.x = x;
+	s.y = y;
+	s.flags |= SPRITE_CHANGED;
+}
+
+void DisplayToolbox::setSpriteBitmap(int8_t id, const uint8_t* bitmap, const uint8_t* mask)
+{
+	sprites[id].bitmap = bitmap;
+	sprites[id].mask = mask;
+	sprites[id].flags |= SPRITE_CHANGED;
+}
+
+void DisplayToolbox::setSpriteVisible(int8_t id, bool visible)
+{
+	if(visible) sprites[id].flags |= SPRITE_VISIBLE;
+	else sprites[id].flags &= ~SPRITE_VISIBLE;
+	sprites[id].flags |= SPRITE_CHANGED;
+}
+
+void DisplayToolbox::setSpriteZ(int8_t id, uint8_t z)
+{
+	sprites[id].z = z;
+	sprites[id].flags |= SPRITE_CHANGED;
+}
+
+// Read a column of a sprite (x is relative to the sprite) and shift it into place
+uint8_t DisplayToolbox::spriteColumn(Sprite& s, int16_t x, bool wantMask)
+{
+	const uint8_t* src = (wantMask && s.mask) ? s.mask : s.bitmap;
+	uint8_t value = (s.flags & SPRITE_PROGMEM) ? pgm_read_byte(src + x) : src[x];
+	
+	if(s.y >= 8 || s.y <= -8) return 0;
+	return s.y >= 0 ? (value << s.y) : (value >> -s.y);
+}
+
+void DisplayToolbox::compositeColumns(int16_t x0, int16_t x1, uint8_t* order, uint8_t orderCount)
+{
+	uint8_t width = disp->getDisplayWidth();
+	int16_t maxX = (int16_t)width * disp->getDisplayCount() - 1;
+	
+	// Clip to the chain
+	if(x0 < 0) x0 = 0;
+	if(x1 > maxX) x1 = maxX;
+	if(!disp->getBuffer(0)) return; // Pass-through display, nothing to draw into
+	
+	for(int16_t x=x0; x<=x1; ++x)
+	{
+		uint8_t dispNum = x / width;
+		uint8_t col = x - (dispNum * width);
+		
+		uint8_t* pBackground = disp->getBuffer(dispNum, true);
+		uint8_t value = pBackground ? pBackground[col] : 0;
+		
+		// Paint sprites bottom to top
+		for(uint8_t i=0; i<orderCount; ++i)
+		{
+			Sprite& s = sprites[order[i]];
+			if(x < s.x || x >= s.x + s.width) continue;
+			
+			uint8_t mask = spriteColumn(s, x - s.x, true);
+			value = (value & ~mask) | (spriteColumn(s, x - s.x, false) & mask);
+		}
+		
+		disp->getBuffer(dispNum)[col] = value;
+		disp->markDirty(dispNum, col);
+	}
+}
+
+void DisplayToolbox::updateSprites()
+{
+	// Spans which need to be rebuilt, old and new position of each changed sprite
+	int16_t spanStart[TOOLBOX_MAX_SPRITES * 2];
+	int16_t spanEnd[TOOLBOX_MAX_SPRITES * 2];
+	uint8_t spanCount = 0;
+	
+	// Visible sprites sorted by z (insertion sort, the pool is tiny)
+	uint8_t order[TOOLBOX_MAX_SPRITES];
+	uint8_t orderCount = 0;
+	
+	for(uint8_t id=0; id<TOOLBOX_MAX_SPRITES; ++id)
+	{
+		Sprite& s = sprites[id];
+		
+		if(s.flags & SPRITE_CHANGED)
+		{
+			if(s.flags & SPRITE_DRAWN)
+			{
+				spanStart[spanCount] = s.drawnX;
+				spanEnd[spanCount++] = s.drawnX + s.width - 1;
+				s.flags &= ~SPRITE_DRAWN;
+			}
+			if((s.flags & (SPRITE_USED | SPRITE_VISIBLE)) == (SPRITE_USED | SPRITE_VISIBLE))
+			{
+				spanStart[spanCount] = s.x;
+				spanEnd[spanCount++] = s.x + s.width - 1;
+			}
+			s.flags &= ~SPRITE_CHANGED;
+		}
+		
+		if((s.flags & (SPRITE_USED | SPRITE_VISIBLE)) != (SPRITE_USED | SPRITE_VISIBLE)) continue;
+		
+		s.drawnX = s.x;
+		s.drawnY = s.y;
+		s.flags |= SPRITE_DRAWN;
+		
+		uint8_t i = orderCount++;
+		while(i > 0 && sprites[order[i-1]].z > s.z)
+		{
+			order[i] = order[i-1];
+			--i;
+		}
+		order[i] = id;
+	}
+	
+	if(spanCount == 0) return;
+	
+	// Sort the spans by their start and merge overlaps so no column is built twice
+	for(uint8_t i=1; i<spanCount; ++i)
+	{
+		int16_t start = spanStart[i];
+		int16_t end = spanEnd[i];
+		uint8_t j = i;
+		while(j > 0 && spanStart[j-1] > start)
+		{
+			spanStart[j] = spanStart[j-1];
+			spanEnd[j] = spanEnd[j-1];
+			--j;
+		}
+		spanStart[j] = start;
+		spanEnd[j] = end;
+	}
+	
+	int16_t runStart = spanStart[0];
+	int16_t runEnd = spanEnd[0];
+	for(uint8_t i=1; i<spanCount; ++i)
+	{
+		if(spanStart[i] <= runEnd + 1)
+		{
+			if(spanEnd[i] > runEnd) runEnd = spanEnd[i];
+			continue;
+		}
+		compositeColumns(runStart, runEnd, order, orderCount);
+		runStart = spanStart[i];
+		runEnd = spanEnd[i];
+	}
+	compositeColumns(runStart, runEnd, order, orderCount);
+}
+
+bool DisplayToolbox::spritesCollide(int8_t a, int8_t b)
+{
+	Sprite& sa = sprites[a];
+	Sprite& sb = sprites[b];
+	
+	// Rows never overlap if one is completely off the display
+	if(sa.y <= -8 || sa.y >= 8 || sb.y <= -8 || sb.y >= 8) return false;
+	
+	// Overlapping columns
+	int16_t x0 = sa.x > sb.x ? sa.x : sb.x;
+	int16_t x1 = (sa.x + sa.width < sb.x + sb.width) ? sa.x + sa.width : sb.x + sb.width;
+	
+	for(int16_t x=x0; x<x1; ++x)
+	{
+		// Work in 32 bits so rows pushed off the display still count
+		const uint8_t* pa = sa.mask ? sa.mask : sa.bitmap;
+		const uint8_t* pb = sb.mask ? sb.mask : sb.bitmap;
+		uint32_t ma = (sa.flags & SPRITE_PROGMEM) ? pgm_read_byte(pa + (x - sa.x)) : pa[x - sa.x];
+		uint32_t mb = (sb.flags & SPRITE_PROGMEM) ? pgm_read_byte(pb + (x - sb.x)) : pb[x - sb.x];
+		
+		if(((ma << (sa.y + 8)) & (mb << (sb.y + 8))) != 0) return true;
+	}
+	return false;
 }
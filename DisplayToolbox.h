@@ -29,6 +29,58 @@
 #include <wiring.h>
 #include "HardwareSerial.h"
 #include <MatrixDisplay.h>
+#include <avr/pgmspace.h>
+#include "PackedFont.h"
+
+// Raster ops, how a primitive combines with what's already in the buffer
+// ROP_CLEAR and ROP_SET match the old 0/1 colour values
+#define ROP_CLEAR   0 // Turn the drawn pixels off
+#define ROP_SET     1 // Turn the drawn pixels on
+#define ROP_XOR     2 // Flip the drawn pixels, drawing twice restores the background
+#define ROP_INVERT  3 // Flip everything the primitive covers (the whole cell for text and bitmaps)
+#define ROP_COPY    4 // Replace the covered area with the pattern (text default)
+
+// Size of the sprite pool
+#define TOOLBOX_MAX_SPRITES 8
+
+// Sprite flags
+#define SPRITE_VISIBLE  0x01 // Composite this sprite
+#define SPRITE_PROGMEM  0x02 // Bitmap and mask live in flash
+#define SPRITE_CHANGED  0x04 // Moved/changed since the last updateSprites()
+#define SPRITE_DRAWN    0x08 // Currently composited at drawnX/drawnY
+#define SPRITE_USED     0x80 // Slot is allocated
+
+// Number of brightness fades which can run at once
+#define TOOLBOX_MAX_FADES 4
+
+// A brightness fade on a group of displays. Levels are perceived brightness (0-255), mapped to PWM through a gamma table
+struct Fade
+{
+	uint32_t panels; // 0 = slot free
+	uint8_t fromLevel;
+	uint8_t toLevel;
+	unsigned long start;
+	unsigned long duration;
+	uint8_t lastPwm;
+};
+
+/*
+A sprite is a strip of up to 8 rows. The bitmap uses the same packing as the display buffer,
+one byte per column with bit 0 as the top row. Set bits in the mask are copied from the bitmap,
+clear bits leave the background alone. A NULL mask means the bitmap is its own mask.
+*/
+struct Sprite
+{
+	const uint8_t* bitmap;
+	const uint8_t* mask;
+	int16_t x;
+	int8_t  y;
+	int16_t drawnX; // Where it was last composited, so we know what to restore
+	int8_t  drawnY;
+	uint8_t width;
+	uint8_t z; // Higher is drawn on top
+	uint8_t flags;
+};
 
 /*
 This is a utility class, it's purpose to provide several useful functions which maybe used frequently but are not core to the MatrixDisplay operation.
@@ -40,7 +92,26 @@ class DisplayToolbox
 {
 private:
 	MatrixDisplay* disp;
+	uint8_t drawColour; // Bi-colour panels only
 	uint8_t calcDispNum(int& x);
+	void applyColumn(int x, uint8_t pattern, uint8_t box, uint8_t op);
+	
+	// Start and end directions of an arc (scaled by 255), wide when it sweeps more than 180 degrees
+	struct Sector
+	{
+		int16_t ax, ay, bx, by;
+		bool wide;
+	};
+	Sector makeSector(int startAngle, int endAngle);
+	void ellipseColumns(int xp, int yp, uint8_t rx, uint8_t ry, uint8_t op, bool filled, const Sector* sector);
+	
+	Sprite sprites[TOOLBOX_MAX_SPRITES];
+	Fade fades[TOOLBOX_MAX_FADES];
+	
+	// Fetch a sprite column shifted into display rows (mask if wantMask is set)
+	uint8_t spriteColumn(Sprite& s, int16_t x, bool wantMask);
+	// Rebuild columns x0 to x1 (inclusive, virtual coordinates) from the background and all visible sprites
+	void compositeColumns(int16_t x0, int16_t x1, uint8_t* order, uint8_t orderCount);
 
 	
 public:	
@@ -51,13 +122,68 @@ public:
     ~DisplayToolbox();
 	
 	
-	void drawCircle(uint8_t xp,uint8_t  yp, uint8_t radius, uint8_t col = 1);
-	void drawLine(uint8_t x1, uint8_t y1, uint8_t x2, uint8_t y2, uint8_t val );
+	// Drawing primitives, the colour/val/op argument is one of the ROP_* values
+	void drawCircle(int xp, int yp, uint8_t radius, uint8_t op = ROP_SET);
+	void fillCircle(int xp, int yp, uint8_t radius, uint8_t op = ROP_SET);
+	void drawEllipse(int xp, int yp, uint8_t rx, uint8_t ry, uint8_t op = ROP_SET);
+	void fillEllipse(int xp, int yp, uint8_t rx, uint8_t ry, uint8_t op = ROP_SET);
+	// Angles in degrees, 0 is 3 o'clock, clockwise. fillArc draws a pie slice
+	void drawArc(int xp, int yp, uint8_t radius, int startAngle, int endAngle, uint8_t op = ROP_SET);
+	void fillArc(int xp, int yp, uint8_t radius, int startAngle, int endAngle, uint8_t op = ROP_SET);
+	void drawLine(int x1, int y1, int x2, int y2, uint8_t val );
 	void setPixel(int x, int y, int val, bool paint = false);
 	uint8_t getPixel(int x, int y, bool fromShadow);
 	void setBrightness(uint8_t pwmValue);
-	void drawRectangle(uint8_t _x, uint8_t _y, uint8_t width, uint8_t height, uint8_t colour, bool filled = false);
+	
+	// Bi-colour panels: colour used by the primitives (COLOUR_GREEN/RED/ORANGE). Ignored on mono panels
+	void setColour(uint8_t colour);
+	
+	// Table driven sine/cosine of an angle in degrees, scaled to +-255
+	static int16_t sin8(int angle);
+	static int16_t cos8(int angle);
+	void drawRectangle(int _x, int _y, uint8_t width, uint8_t height, uint8_t colour, bool filled = false);
+	void drawBitmap(int x, int y, const uint8_t* bitmap, uint8_t width, uint8_t height, uint8_t op = ROP_COPY, bool inProgmem = false);
 	//void drawFilledRectangle(int, int, int, int, int);
+	
+	// Affine blit, the bitmap (column packed, up to 8 rows) is centred on (cx, cy) and sampled through
+	// 8.8 fixed point steps: source (u, v) moves by (dudx, dvdx) per display column and (dudy, dvdy) per row.
+	// Clipped to the chain, each output column is assembled in a byte and written once
+	void drawAffine(int cx, int cy, const uint8_t* bitmap, uint8_t width, uint8_t height,
+					int16_t dudx, int16_t dvdx, int16_t dudy, int16_t dvdy, uint8_t op = ROP_COPY, bool inProgmem = false);
+	// Rotozoom, angle in degrees clockwise, scale is 8.8 (256 = actual size, 512 = double).
+	// Scales from 3 (1/85 size) up are exact, 1 and 2 are drawn as about 1/128
+	void drawRotated(int cx, int cy, const uint8_t* bitmap, uint8_t width, uint8_t height,
+					 int angle, uint16_t scale = 256, uint8_t op = ROP_COPY, bool inProgmem = false);
+	
+	// Text using a packed font (see PackedFont.h). y is the top row and may be negative
+	// Returns the number of columns used
+	uint8_t drawChar(int x, int y, char c, const PackedFont& font, uint8_t op = ROP_COPY);
+	int drawString(int x, int y, const char* str, const PackedFont& font, uint8_t op = ROP_COPY);
+	int getStringWidth(const char* str, const PackedFont& font);
+	
+	// Brightness fades
+	// Starts a fade from one perceived level to another (0-255) over duration milliseconds on a group of displays (bit n = display n).
+	// A new fade replaces any running fade on the same displays. Returns false when all fade slots are busy
+	bool fadeBrightness(uint32_t panelMask, uint8_t fromLevel, uint8_t toLevel, unsigned long duration);
+	// Advance the fades, call from loop(). Only sends a command when a group's PWM step changes. Returns true while fading
+	bool updateFades();
+	void stopFades();
+	
+	// Sprites
+	// The background is taken from the shadow buffer (call copyBuffer() once the scene is drawn), or blank when there's no shadow
+	// Returns the sprite id or -1 when the pool is full
+	int8_t addSprite(const uint8_t* bitmap, const uint8_t* mask, uint8_t width, bool inProgmem = false, uint8_t z = 0);
+	void removeSprite(int8_t id);
+	void moveSprite(int8_t id, int16_t x, int8_t y);
+	void setSpriteBitmap(int8_t id, const uint8_t* bitmap, const uint8_t* mask);
+	void setSpriteVisible(int8_t id, bool visible);
+	void setSpriteZ(int8_t id, uint8_t z);
+	
+	// Composite the areas which changed into the back buffer and flag them dirty. Follow with disp->syncDirty()
+	void updateSprites();
+	
+	// Pixel perfect collision test (mask AND mask)
+	bool spritesCollide(int8_t a, int8_t b);
 };
 
 #endif
@@ -0,0 +1,167 @@
+/*
+	MatrixDisplay Library 2.0
+	Author: Miles Burton, www.milesburton.com/
+	Need a 16x24 display? Check out www.mnethardware.co.uk
+	Copyright (c) 2010 Miles Burton All Rights Reserved
+
+	This library is free software; you can redistribute it and/or
+	modify it under the terms of the GNU Lesser General Public
+	License as published by the Free Software Foundation; either
+	version 2.1 of the License, or (at your option) any later version.
+
+	This library is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+	Lesser General Public License for more details.
+
+	You should have received a copy of the GNU Lesser General Public
+	License along with this library; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+
+#include "FrameScheduler.h"
+
+#define DEFAULT_MAX_CATCHUP 4
+
+///////////////////////////////////////////////////////////////////////////////
+//  CTORS & DTOR
+//
+FrameScheduler::FrameScheduler(uint8_t fps, FrameCallback update, FrameCallback render, FrameCallback idle)
+	: updateCallback(update)
+	, renderCallback(render)
+	, idleCallback(idle)
+#if defined(ARDUINO)
+	, clock(micros)
+#else
+	, clock(NULL)
+#endif
+	, period(0)
+	, nextTick(0)
+	, maxCatchUp(DEFAULT_MAX_CATCHUP)
+	, started(false)
+{
+	setFps(fps);
+	resetStats();
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//  PUBLIC FUNCTIONS
+//
+void FrameScheduler::setClock(ClockSource source)
+{
+	clock = source;
+	started = false;
+}
+
+void FrameScheduler::setFps(uint8_t fps)
+{
+	if(fps == 0) fps = 1;
+	period = 1000000UL / fps;
+}
+
+void FrameScheduler::setMaxCatchUp(uint8_t steps)
+{
+	maxCatchUp = steps ? steps : 1;
+}
+
+void FrameScheduler::reset()
+{
+	if(!clock) return;
+	nextTick = clock();
+	started = true;
+}
+
+void FrameScheduler::tick()
+{
+	if(!clock) return; // No time source (host build without setClock)
+	if(!started) reset();
+	
+	unsigned long now = clock();
+	
+	// Not due yet, hand the spare time to the background task
+	// (signed compare so micros() rollover is harmless)
+	if((long)(now - nextTick) < 0)
+	{
+		if(idleCallback) idleCallback();
+		return;
+	}
+	
+	// How late we are for this step
+	unsigned long lateness = now - nextTick;
+	if(lateness > maxJitter) maxJitter = lateness;
+	jitterTotal += lateness;
+	++jitterSamples;
+	
+	uint8_t steps = 0;
+	while((long)(now - nextTick) >= 0 && steps < maxCatchUp)
+	{
+		if(updateCallback) updateCallback();
+		nextTick += period;
+		++frameCount;
+		++steps;
+	}
+	
+	// Too far behind to ever catch up, drop the missed time
+	if((long)(now - nextTick) >= 0)
+	{
+		++overruns;
+		nextTick = now + period;
+	}
+	
+	// If the updates ran past the next deadline there's no time to render
+	if((long)(clock() - nextTick) >= 0)
+	{
+		++skippedRenders;
+		return;
+	}
+	
+	if(renderCallback) renderCallback();
+	++renderCount;
+	
+	// Rendering made us miss the next step
+	if((long)(clock() - nextTick) >= 0) ++overruns;
+}
+
+unsigned long FrameScheduler::getFrameCount()
+{
+	return frameCount;
+}
+
+unsigned long FrameScheduler::getRenderCount()
+{
+	return renderCount;
+}
+
+unsigned long FrameScheduler::getSkippedRenders()
+{
+	return skippedRenders;
+}
+
+unsigned long FrameScheduler::getOverruns()
+{
+	return overruns;
+}
+
+unsigned long FrameScheduler::getMaxJitter()
+{
+	return maxJitter;
+}
+
+unsigned long FrameScheduler::getAverageJitter()
+{
+	if(jitterSamples == 0) return 0;
+	return jitterTotal / jitterSamples;
+}
+
+void FrameScheduler::resetStats()
+{
+	frameCount = 0;
+	renderCount = 0;
+	skippedRenders = 0;
+	overruns = 0;
+	maxJitter = 0;
+	jitterTotal = 0;
+	jitterSamples = 0;
+}
@@ -0,0 +1,95 @@
+/*
+	MatrixDisplay Library 2.0
+	Author: Miles Burton, www.milesburton.com/
+	Need a 16x24 display? Check out www.mnethardware.co.uk
+	Copyright (c) 2010 Miles Burton All Rights Reserved
+
+	This library is free software; you can redistribute it and/or
+	modify it under the terms of the GNU Lesser General Public
+	License as published by the Free Software Foundation; either
+	version 2.1 of the License, or (at your option) any later version.
+
+	This library is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+	Lesser General Public License for more details.
+
+	You should have received a copy of the GNU Lesser General Public
+	License along with this library; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#ifndef FRAME_SCHEDULER_GUARD
+#define FRAME_SCHEDULER_GUARD
+
+#include <inttypes.h>
+#include <stdlib.h>
+#if defined(ARDUINO)
+#include <wiring.h>
+#endif
+
+/*
+Runs update/render callbacks at a fixed rate instead of pacing the loop with delay().
+
+update() runs once per timestep and catches up (up to maxCatchUp steps) if we fall behind.
+render() runs once per tick() that had updates, unless we're still behind afterwards, in which
+case the render is skipped to let the updates catch up. Time left before the next step is handed
+to idle() for background work (serial parsing etc), one call per tick().
+
+The clock is pluggable so the scheduler can be driven by a simulated clock on the host. Off the
+Arduino there's no default, tick() does nothing until setClock() is called.
+*/
+
+typedef void (*FrameCallback)();
+typedef unsigned long (*ClockSource)(); // Microseconds
+
+class FrameScheduler
+{
+private:
+	FrameCallback updateCallback;
+	FrameCallback renderCallback;
+	FrameCallback idleCallback;
+	ClockSource clock;
+	
+	unsigned long period; // Microseconds per step
+	unsigned long nextTick;
+	uint8_t maxCatchUp;
+	bool started;
+	
+	// Statistics
+	unsigned long frameCount;
+	unsigned long renderCount;
+	unsigned long skippedRenders;
+	unsigned long overruns;
+	unsigned long maxJitter;
+	unsigned long jitterTotal;
+	unsigned long jitterSamples;
+	
+public:
+	// Constructor
+	// fps - target updates per second
+	// idle may be NULL
+	FrameScheduler(uint8_t fps, FrameCallback update, FrameCallback render, FrameCallback idle = NULL);
+	
+	void setClock(ClockSource source);
+	void setFps(uint8_t fps);
+	// How many updates we'll run back to back before giving up and dropping time
+	void setMaxCatchUp(uint8_t steps);
+	
+	// Call from loop(). Never blocks
+	void tick();
+	
+	// Restart the time base from now (e.g. after a blocking operation)
+	void reset();
+	
+	// Statistics
+	unsigned long getFrameCount();
+	unsigned long getRenderCount();
+	unsigned long getSkippedRenders();
+	unsigned long getOverruns(); // Frames whose work didn't fit in the timestep
+	unsigned long getMaxJitter(); // Microseconds
+	unsigned long getAverageJitter();
+	void resetStats();
+};
+
+#endif
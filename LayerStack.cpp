@@ -0,0 +1,245 @@
+/*
+	MatrixDisplay Library 2.0
+	Author: Miles Burton, www.milesburton.com/
+	Need a 16x24 display? Check out www.mnethardware.co.uk
+	Copyright (c) 2010 Miles Burton All Rights Reserved
+
+	This library is free software; you can redistribute it and/or
+	modify it under the terms of the GNU Lesser General Public
+	License as published by the Free Software Foundation; either
+	version 2.1 of the License, or (at your option) any later version.
+
+	This library is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+	Lesser General Public License for more details.
+
+	You should have received a copy of the GNU Lesser General Public
+	License along with this library; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+
+#include "LayerStack.h"
+
+///////////////////////////////////////////////////////////////////////////////
+//  CTORS & DTOR
+//
+LayerStack::LayerStack(MatrixDisplay* _disp, uint8_t _layerCount)
+	: disp(_disp)
+	, layerCount(_layerCount > MAX_LAYERS ? MAX_LAYERS : _layerCount)
+	, chainWidth((uint16_t)_disp->getDisplayWidth() * _disp->getDisplayCount())
+	, pDirty(NULL)
+	, colour(COLOUR_GREEN)
+{
+	memset(layers, 0, sizeof(layers));
+	for(uint8_t i=0; i<layerCount; ++i)
+	{
+		layers[i].buffer = (uint8_t *)malloc(chainWidth);
+		memset(layers[i].buffer, 0, chainWidth);
+		layers[i].visible = true;
+		layers[i].op = LAYER_OR;
+	}
+	
+	pDirty = (uint8_t *)malloc((chainWidth + 7) / 8);
+	markAllDirty();
+}
+
+LayerStack::~LayerStack()
+{
+	for(uint8_t i=0; i<layerCount; ++i)
+	{
+		if(layers[i].buffer)
+		{
+			free(layers[i].buffer);
+			layers[i].buffer = NULL;
+		}
+	}
+	
+	if(pDirty)
+	{
+		free(pDirty);
+		pDirty = NULL;
+	}
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//  PUBLIC FUNCTIONS
+//
+uint8_t* LayerStack::getBuffer(uint8_t layer)
+{
+	return layers[layer].buffer;
+}
+
+void LayerStack::setPixel(uint8_t layer, uint16_t x, uint8_t y, uint8_t value)
+{
+	if(x >= chainWidth || y > 7) return;
+	
+	if(value) layers[layer].buffer[x] |= (1 << y);
+	else layers[layer].buffer[x] &= ~(1 << y);
+	markDirty(layer, x, x);
+}
+
+void LayerStack::clear(uint8_t layer)
+{
+	memset(layers[layer].buffer, 0, chainWidth);
+	markAllDirty();
+}
+
+void LayerStack::setVisible(uint8_t layer, bool visible)
+{
+	if(layers[layer].visible == visible) return;
+	layers[layer].visible = visible;
+	markAllDirty();
+}
+
+void LayerStack::setOffset(uint8_t layer, int16_t x, int8_t y)
+{
+	if(layers[layer].offsetX == x && layers[layer].offsetY == y) return;
+	layers[layer].offsetX = x;
+	layers[layer].offsetY = y;
+	markAllDirty();
+}
+
+// Colour of the composited image on bi-colour panels (COLOUR_GREEN, COLOUR_RED or COLOUR_ORANGE)
+void LayerStack::setColour(uint8_t _colour)
+{
+	if(colour == _colour) return;
+	colour = _colour;
+	markAllDirty();
+}
+
+void LayerStack::setOp(uint8_t layer, uint8_t op)
+{
+	layers[layer].op = op;
+	markAllDirty();
+}
+
+void LayerStack::markDirty(uint8_t layer, uint16_t x0, uint16_t x1)
+{
+	// Into screen columns
+	int16_t s0 = (int16_t)x0 + layers[layer].offsetX;
+	int16_t s1 = (int16_t)x1 + layers[layer].offsetX;
+	if(s0 < 0) s0 = 0;
+	if(s1 >= (int16_t)chainWidth) s1 = chainWidth - 1;
+	
+	for(int16_t x=s0; x<=s1; ++x) pDirty[x >> 3] |= (1 << (x & 7));
+}
+
+void LayerStack::markAllDirty()
+{
+	memset(pDirty, 0xFF, (chainWidth + 7) / 8);
+}
+
+void LayerStack::compose()
+{
+	if(!disp->getBuffer(0)) return; // Pass-through display, nothing to compose into
+	
+	uint16_t x = 0;
+	while(x < chainWidth)
+	{
+		// Skip clean bytes of flags in one go
+		if((x & 7) == 0 && pDirty[x >> 3] == 0)
+		{
+			x += 8;
+			continue;
+		}
+		if(!(pDirty[x >> 3] & (1 << (x & 7))))
+		{
+			++x;
+			continue;
+		}
+		
+		uint16_t runStart = x;
+		while(x < chainWidth && (pDirty[x >> 3] & (1 << (x & 7)))) ++x;
+		composeRun(runStart, x);
+	}
+	
+	memset(pDirty, 0, (chainWidth + 7) / 8);
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//  PRIVATE FUNCTIONS
+//
+
+// Rebuild screen columns x0 up to (not including) x1
+void LayerStack::composeRun(uint16_t x0, uint16_t x1)
+{
+	// Layers span the chain but the back buffer is per display, planeWidth columns per plane and
+	// on bi-colour panels a red plane after the green one. Split the run at display boundaries
+	uint8_t width = disp->getDisplayWidth();
+	uint8_t planes = disp->getPlaneCount();
+	
+	while(x0 < x1)
+	{
+		uint8_t dispNum = x0 / width;
+		uint8_t col = x0 % width;
+		uint8_t n = (x1 - x0 < width - col) ? (x1 - x0) : (width - col);
+		
+		uint8_t* green = disp->getBuffer(dispNum) + col;
+		composeSpan(green, x0, x0 + n);
+		
+		// The composited image goes into the planes of the layer colour, the others are cleared
+		if(planes > 1)
+		{
+			uint8_t* red = green + width;
+			if(colour & COLOUR_RED) memcpy(red, green, n);
+			else memset(red, 0, n);
+			if(!(colour & COLOUR_GREEN)) memset(green, 0, n);
+		}
+		
+		for(uint8_t j=0; j<n; ++j)
+		{
+			for(uint8_t plane=0; plane<planes; ++plane) disp->markDirty(dispNum, col + j + (plane * width));
+		}
+		x0 += n;
+	}
+}
+
+// Composite all the layers into dst, which holds screen columns x0 up to (not including) x1
+void LayerStack::composeSpan(uint8_t* dst, uint16_t x0, uint16_t x1)
+{
+	memset(dst, 0, x1 - x0);
+	
+	for(uint8_t i=0; i<layerCount; ++i)
+	{
+		Layer& l = layers[i];
+		if(!l.visible) continue;
+		if(l.offsetY >= 8 || l.offsetY <= -8) continue;
+		
+		// Clip the span against the layer
+		int16_t s0 = (int16_t)x0 - l.offsetX;
+		int16_t s1 = (int16_t)x1 - l.offsetX;
+		if(s0 < 0) s0 = 0;
+		if(s1 > (int16_t)chainWidth) s1 = chainWidth;
+		if(s0 >= s1) continue;
+		
+		uint8_t* d = dst + (s0 + l.offsetX - x0);
+		const uint8_t* src = l.buffer + s0;
+		uint16_t n = s1 - s0;
+		
+		// One plain loop per op and shift direction, no branches inside, so the compiler can vectorise them
+		if(l.offsetY >= 0)
+		{
+			uint8_t shift = l.offsetY;
+			switch(l.op)
+			{
+			case LAYER_OR:   for(uint16_t j=0; j<n; ++j) d[j] |= (uint8_t)(src[j] << shift); break;
+			case LAYER_MASK: for(uint16_t j=0; j<n; ++j) d[j] &= (uint8_t)~(src[j] << shift); break;
+			case LAYER_XOR:  for(uint16_t j=0; j<n; ++j) d[j] ^= (uint8_t)(src[j] << shift); break;
+			}
+		}
+		else
+		{
+			uint8_t shift = -l.offsetY;
+			switch(l.op)
+			{
+			case LAYER_OR:   for(uint16_t j=0; j<n; ++j) d[j] |= (uint8_t)(src[j] >> shift); break;
+			case LAYER_MASK: for(uint16_t j=0; j<n; ++j) d[j] &= (uint8_t)~(src[j] >> shift); break;
+			case LAYER_XOR:  for(uint16_t j=0; j<n; ++j) d[j] ^= (uint8_t)(src[j] >> shift); break;
+			}
+		}
+	}
+}
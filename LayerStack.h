@@ -0,0 +1,93 @@
+/*
+	MatrixDisplay Library 2.0
+	Author: Miles Burton, www.milesburton.com/
+	Need a 16x24 display? Check out www.mnethardware.co.uk
+	Copyright (c) 2010 Miles Burton All Rights Reserved
+
+	This library is free software; you can redistribute it and/or
+	modify it under the terms of the GNU Lesser General Public
+	License as published by the Free Software Foundation; either
+	version 2.1 of the License, or (at your option) any later version.
+
+	This library is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+	Lesser General Public License for more details.
+
+	You should have received a copy of the GNU Lesser General Public
+	License along with this library; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#ifndef LAYER_STACK_GUARD
+#define LAYER_STACK_GUARD
+
+#include <inttypes.h>
+#include <string.h>
+#include <stdlib.h>
+#include <MatrixDisplay.h>
+
+// Most layers a stack can hold
+#define MAX_LAYERS 4
+
+// How a layer is combined with the layers below it
+#define LAYER_OR    0 // Set where the layer is set
+#define LAYER_MASK  1 // Clear where the layer is set (AND-NOT)
+#define LAYER_XOR   2 // Invert where the layer is set
+
+struct Layer
+{
+	uint8_t* buffer; // Same shape as the display's back buffer, one byte per column across the whole chain
+	int16_t offsetX;
+	int8_t  offsetY;
+	uint8_t op;
+	bool    visible;
+};
+
+/*
+A stack of packed buffers composited into the display's back buffer, bottom (layer 0) to top.
+
+Draw into a layer with setPixel() or straight into getBuffer() followed by markDirty(). compose()
+only rebuilds the columns which changed since the last call, a whole column byte at a time, and flags
+them for disp.syncDirty(). Moving or hiding a layer marks everything dirty. On bi-colour panels the
+stack composites one image and shows it in the colour set with setColour().
+*/
+
+class LayerStack
+{
+private:
+	MatrixDisplay* disp;
+	Layer layers[MAX_LAYERS];
+	uint8_t layerCount;
+	uint16_t chainWidth; // Columns across the chain
+	uint8_t* pDirty; // One bit per chain column
+	uint8_t colour; // Planes drawn into on bi-colour panels
+	
+	void composeRun(uint16_t x0, uint16_t x1);
+	void composeSpan(uint8_t* dst, uint16_t x0, uint16_t x1);
+	
+public:	
+	// Constructor, allocates layerCount buffers the size of the display's back buffer
+	LayerStack(MatrixDisplay* disp, uint8_t layerCount);
+	
+	// Destructor
+	~LayerStack();
+	
+	uint8_t* getBuffer(uint8_t layer);
+	void	setPixel(uint8_t layer, uint16_t x, uint8_t y, uint8_t value);
+	void	clear(uint8_t layer);
+	
+	void	setVisible(uint8_t layer, bool visible);
+	void	setOffset(uint8_t layer, int16_t x, int8_t y);
+	void	setOp(uint8_t layer, uint8_t op);
+	void	setColour(uint8_t colour);
+	
+	// Flag columns x0 to x1 (layer coordinates, inclusive) as changed
+	void	markDirty(uint8_t layer, uint16_t x0, uint16_t x1);
+	void	markAllDirty();
+	
+	// Rebuild the changed columns of the back buffer
+	void	compose();
+};
+
+#endif
@@ -0,0 +1,190 @@
+/*
+	MatrixDisplay Library 2.0
+	Author: Miles Burton, www.milesburton.com/
+	Need a 16x24 display? Check out www.mnethardware.co.uk
+	Copyright (c) 2010 Miles Burton All Rights Reserved
+
+	This library is free software; you can redistribute it and/or
+	modify it under the terms of the GNU Lesser General Public
+	License as published by the Free Software Foundation; either
+	version 2.1 of the License, or (at your option) any later version.
+
+	This library is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+	Lesser General Public License for more details.
+
+	You should have received a copy of the GNU Lesser General Public
+	License along with this library; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+
+#include "Marquee.h"
+
+// Reverse the bits of a nybble, used to flip font.h columns (MSB at the top) to the buffer layout
+static const uint8_t PROGMEM reverseNibble[16] = {
+	0x0, 0x8, 0x4, 0xC, 0x2, 0xA, 0x6, 0xE, 0x1, 0x9, 0x5, 0xD, 0x3, 0xB, 0x7, 0xF
+};
+
+///////////////////////////////////////////////////////////////////////////////
+//  CTORS & DTOR
+//
+Marquee::Marquee(MatrixDisplay* _disp, int16_t _x, uint8_t _width, int8_t _y)
+	: disp(_disp)
+	, x(_x)
+	, width(_width)
+	, y(_y)
+	, rowMask(0xFF)
+	, text(NULL)
+	, textInProgmem(false)
+	, loop(true)
+	, fixedFont(NULL)
+	, fixedWidth(5)
+	, packedFont(NULL)
+{
+	restart();
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//  PUBLIC FUNCTIONS
+//
+void Marquee::setText(const char* _text, bool inProgmem)
+{
+	text = _text;
+	textInProgmem = inProgmem;
+	restart();
+}
+
+void Marquee::setFont(const uint8_t* glyphs, uint8_t glyphWidth)
+{
+	fixedFont = glyphs;
+	fixedWidth = glyphWidth;
+	packedFont = NULL;
+	updateRowMask();
+}
+
+void Marquee::setFont(const PackedFont* font)
+{
+	packedFont = font;
+	fixedFont = NULL;
+	updateRowMask();
+}
+
+void Marquee::setLoop(bool _loop)
+{
+	loop = _loop;
+}
+
+void Marquee::restart()
+{
+	charIndex = 0;
+	glyphColumn = 0;
+	trailing = 0;
+	finished = false;
+}
+
+bool Marquee::step()
+{
+	if(finished) return false;
+	if(!disp->getBuffer(0)) return false; // Pass-through display, nothing to scroll
+	
+	uint8_t panelWidth = disp->getDisplayWidth();
+	int16_t chainWidth = (int16_t)panelWidth * disp->getDisplayCount();
+	uint8_t incoming = nextColumn();
+	
+	// Walk the zone left to right pulling each column from its right hand neighbour
+	uint8_t* pPrev = NULL;
+	for(int16_t px = x; px < x + width; ++px)
+	{
+		if(px < 0 || px >= chainWidth) continue;
+		
+		uint8_t dispNum = px / panelWidth;
+		uint8_t col = px - (dispNum * panelWidth);
+		uint8_t* pCol = disp->getBuffer(dispNum) + col;
+		
+		if(pPrev) *pPrev = (*pPrev & ~rowMask) | (*pCol & rowMask);
+		disp->markDirty(dispNum, col);
+		pPrev = pCol;
+	}
+	
+	// The new column enters at the right edge
+	if(pPrev) *pPrev = (*pPrev & ~rowMask) | (incoming & rowMask);
+	
+	return true;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//  PRIVATE FUNCTIONS
+//
+void Marquee::updateRowMask()
+{
+	uint8_t height = packedFont ? packedFont->height : 8;
+	uint8_t mask = height >= 8 ? 0xFF : (1 << height) - 1;
+	
+	if(y >= 8 || y <= -8) rowMask = 0;
+	else rowMask = y >= 0 ? (mask << y) : (mask >> -y);
+}
+
+char Marquee::currentChar()
+{
+	if(text == NULL) return 0;
+	return textInProgmem ? (char)pgm_read_byte(text + charIndex) : text[charIndex];
+}
+
+// Rasterize the next column of the message, shifted into the zone's rows
+uint8_t Marquee::nextColumn()
+{
+	char c = currentChar();
+	
+	if(c == 0)
+	{
+		// Message is done, keep feeding blanks until it has left the zone
+		if(++trailing >= width)
+		{
+			if(loop) restart();
+			else finished = true;
+		}
+		return 0;
+	}
+	
+	uint8_t value = 0;
+	uint8_t glyphWidth = 0;
+	uint8_t ch = (uint8_t)c;
+	
+	if(packedFont)
+	{
+		if(ch >= packedFont->firstChar && ch <= packedFont->lastChar)
+		{
+			ch -= packedFont->firstChar;
+			glyphWidth = pgm_read_byte(packedFont->widths + ch);
+			if(glyphColumn < glyphWidth)
+			{
+				value = pgm_read_byte(packedFont->columns + pgm_read_word(packedFont->offsets + ch) + glyphColumn);
+			}
+		}
+		glyphWidth += packedFont->spacing;
+	}
+	else if(fixedFont)
+	{
+		glyphWidth = fixedWidth;
+		if(glyphColumn < fixedWidth && ch < 128)
+		{
+			uint8_t dots = pgm_read_byte(fixedFont + (ch * fixedWidth) + glyphColumn);
+			value = (pgm_read_byte(&reverseNibble[dots & 0x0F]) << 4) | pgm_read_byte(&reverseNibble[dots >> 4]);
+		}
+		glyphWidth += 1; // One blank column between glyphs
+	}
+	
+	// Move the cursor along
+	if(++glyphColumn >= glyphWidth)
+	{
+		glyphColumn = 0;
+		++charIndex;
+	}
+	
+	if(y >= 8 || y <= -8) return 0;
+	return y >= 0 ? (value << y) : (value >> -y);
+}
@@ -0,0 +1,88 @@
+/*
+	MatrixDisplay Library 2.0
+	Author: Miles Burton, www.milesburton.com/
+	Need a 16x24 display? Check out www.mnethardware.co.uk
+	Copyright (c) 2010 Miles Burton All Rights Reserved
+
+	This library is free software; you can redistribute it and/or
+	modify it under the terms of the GNU Lesser General Public
+	License as published by the Free Software Foundation; either
+	version 2.1 of the License, or (at your option) any later version.
+
+	This library is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+	Lesser General Public License for more details.
+
+	You should have received a copy of the GNU Lesser General Public
+	License along with this library; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#ifndef MARQUEE_GUARD
+#define MARQUEE_GUARD
+
+#include <inttypes.h>
+#include <string.h>
+#include <stdlib.h>
+#include <avr/pgmspace.h>
+#include <MatrixDisplay.h>
+#include "PackedFont.h"
+
+/*
+Scrolls a message through a strip of the display without rendering it anywhere first.
+
+Only the string pointer and a cursor are kept. Each step() shifts the zone left by one column
+(byte operations on the back buffer) and rasterizes the single column which appears at the right
+edge, so RAM use is the same whatever the length of the message. Zones are independent, use as
+many as you like side by side or, with fonts shorter than 8 rows, above each other.
+
+Call disp.syncDirty() after stepping, only the zone's columns are sent.
+*/
+
+class Marquee
+{
+private:
+	MatrixDisplay* disp;
+	int16_t x;
+	uint8_t width;
+	int8_t y;
+	uint8_t rowMask; // Rows owned by this zone
+	
+	const char* text;
+	bool textInProgmem;
+	bool loop;
+	
+	// Fixed width font in the font.h layout (ASCII indexed, MSB is the top row)
+	const uint8_t* fixedFont;
+	uint8_t fixedWidth;
+	// ...or a packed font
+	const PackedFont* packedFont;
+	
+	// Cursor
+	uint16_t charIndex;
+	uint8_t glyphColumn;
+	uint8_t trailing; // Blank columns left to push the end of the message out
+	bool finished;
+	
+	char currentChar();
+	uint8_t nextColumn();
+	void updateRowMask();
+	
+public:	
+	// Constructor
+	// x, width - the columns (virtual, across the chain) used by the zone
+	// y - top row of the text
+	Marquee(MatrixDisplay* disp, int16_t x, uint8_t width, int8_t y = 0);
+	
+	void setText(const char* text, bool inProgmem = false);
+	void setFont(const uint8_t* glyphs, uint8_t glyphWidth = 5); // e.g. (const uint8_t*)myfont
+	void setFont(const PackedFont* font);
+	void setLoop(bool loop);
+	
+	// Scroll one column. Returns false once a non looping message has scrolled out
+	bool step();
+	void restart();
+};
+
+#endif
@@ -43,9 +43,31 @@ PORTC &= ~(1 << (_pin -14) ))
 #define CalcBit(y) (1 << (y > 7 ? y -8 : y))
 
 #include "MatrixDisplay.h"
+#include <avr/pgmspace.h>
+#include <avr/eeprom.h>
 
 #define NULL                0
 #define BACKBUFFER_SIZE     32
+#define DIRTY_BYTES         (BACKBUFFER_SIZE / 8)
+
+// Set bits in a nybble, for counting lit LEDs
+static const uint8_t PROGMEM nibbleBitCount[16] = { 0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4 };
+
+// Sync planner defaults, in clocked bits. A write costs 3 ID + 7 address bits, then 4 per nybble.
+// Chip select has no clock edges so it isn't counted, raise transactionBits to charge for it
+#define SYNC_TRANSACTION_BITS 10
+#define SYNC_NIBBLE_BITS      4
+
+// Calibration. Each column of a test frame is its pattern byte, inverted on odd columns, the
+// last one counts so addressing errors show up too. Settings this many steps above the fastest
+// one which passed are used, unless that was no delay at all
+static const uint8_t PROGMEM busPatterns[] = { 0x00, 0xFF, 0x55, 0xA5, 0x1D };
+#define BUS_PATTERN_COUNT       5
+#define BUS_CALIBRATION_MARGIN  2
+#define BUS_EEPROM_MAGIC        0xB5
+
+// Queued paint-through writes this many nybbles apart are still merged into one run
+#define WRITE_COMBINE_GAP   1
 
 #define DIRTY_BIT           0x80
 
@@ -54,19 +76,41 @@ PORTC &= ~(1 << (_pin -14) ))
 //  CTORS & DTOR
 //
 // Setup the buffers within the constructor, a little more inflexible but saves pain later on
-MatrixDisplay::MatrixDisplay(uint8_t numDisplays, uint8_t clkPin, uint8_t dataPin, bool buildShadow)
-    : pDisplayBuffers(NULL)
+MatrixDisplay::MatrixDisplay(uint8_t numDisplays, uint8_t clkPin, uint8_t dataPin, bool buildShadow, bool buildBackBuffer)
+    : pShadowBuffers(NULL)
+    , pDisplayBuffers(NULL)
     , pDisplayPins(NULL)
+    , pDirtyColumns(NULL)
     , dataPin(dataPin)
     , clkPin(clkPin)
     , displayCount(numDisplays)
 	, backBufferSize(sizeof(uint8_t) * BACKBUFFER_SIZE)
+	, planeWidth(BACKBUFFER_SIZE)
+	, verbose(false)
+	, writeCombineLimit(0)
+	, pPanelBuffers(NULL)
+	, transactionBits(SYNC_TRANSACTION_BITS)
+	, nibbleBits(SYNC_NIBBLE_BITS)
+	, lastSyncBits(0)
+	, pBrightness(NULL)
+	, pLitCounts(NULL)
+	, currentBudget(0)
+	, rdPin(BUS_NO_PIN)
+	, busDelay(0)
+	, pBusDelays(NULL)
 {
     // allocate RAM buffer for display bits
     // 32 columns * 8 rows / 8 bits = 32 bytes
-    uint8_t sz = displayCount * backBufferSize;
-    pDisplayBuffers = (uint8_t *)malloc(sz);
-    memset(pDisplayBuffers, 0, sz); 
+    uint16_t sz = displayCount * backBufferSize;
+	memset(queuedDisplay, -1, sizeof(queuedDisplay));
+	memset(queuedStart, 0, sizeof(queuedStart));
+	memset(queuedEnd, 0, sizeof(queuedEnd));
+	
+	if(buildBackBuffer)
+	{
+		pDisplayBuffers = (uint8_t *)malloc(sz);
+		memset(pDisplayBuffers, 0, sz); 
+	}
 	
 	if(buildShadow)
 	{
@@ -78,6 +122,22 @@ MatrixDisplay::MatrixDisplay(uint8_t numDisplays, uint8_t clkPin, uint8_t dataPi
     // allocate a buffer for pin assignments
     pDisplayPins = (uint8_t *) malloc( sizeof(uint8_t) * numDisplays );
     memset(pDisplayPins, 0, sizeof(uint8_t) * numDisplays);
+	
+	// allocate the dirty column flags (32 columns / 8 bits = 4 bytes per display)
+	pDirtyColumns = (uint8_t *) malloc( DIRTY_BYTES * numDisplays );
+	memset(pDirtyColumns, 0, DIRTY_BYTES * numDisplays);
+	
+	// Brightness asked for (low nybble) and actually set (high nybble), initDisplay starts them at 15
+	pBrightness = (uint8_t *) malloc( numDisplays );
+	memset(pBrightness, 0xFF, numDisplays);
+	
+	// Lit LEDs per display as of the last sync
+	pLitCounts = (uint16_t *) malloc( sizeof(uint16_t) * numDisplays );
+	memset(pLitCounts, 0, sizeof(uint16_t) * numDisplays);
+	
+	// Bus delay per display, flat out until calibrated
+	pBusDelays = (uint8_t *) malloc( numDisplays );
+	memset(pBusDelays, 0, numDisplays);
     
     // set data & clock pin modes
     pinMode(dataPin, OUTPUT);
@@ -107,6 +167,32 @@ MatrixDisplay::~MatrixDisplay()
 		free(pShadowBuffers);
 		pShadowBuffers = NULL;		
 	}
+	
+	if(pDirtyColumns)
+	{
+		free(pDirtyColumns);
+		pDirtyColumns = NULL;
+	}
+	
+	trackPanelContents(false);
+	
+	if(pBrightness)
+	{
+		free(pBrightness);
+		pBrightness = NULL;
+	}
+	
+	if(pLitCounts)
+	{
+		free(pLitCounts);
+		pLitCounts = NULL;
+	}
+	
+	if(pBusDelays)
+	{
+		free(pBusDelays);
+		pBusDelays = NULL;
+	}
 }
 
 
@@ -115,113 +201,216 @@ MatrixDisplay::~MatrixDisplay()
 //
 void MatrixDisplay::initDisplay(uint8_t displayNum, uint8_t pin, bool master)
 {        
-    int myint = (int) displayNum;
 	// Associate the pin with this display
 	pDisplayPins[displayNum] = pin;
 	// init the hardware
 	pinMode(pin, OUTPUT);
 	bitBlast(pin, 1); // Disable chip (pull high)
 	
-	selectDisplay(displayNum);
-	// Send Precommand
-	preCommand();
 	// Take advantage of successive mode and write the options
-	writeDataBE(8,HT1632_CMD_SYSDIS, true);
-	writeDataBE(8,HT1632_CMD_COMS10,true);
-	if(master)
-    {
-        writeDataBE(8,HT1632_CMD_MSTMD,true);
-        Serial.print(myint);
-        Serial.println(" is Master");
-    }
-    else
-    {
-        writeDataBE(8,HT1632_CMD_SLVMD,true);        
-        Serial.print(myint);
-        Serial.println(" is Slave");
-    }
-	writeDataBE(8,HT1632_CMD_SYSEN,true);
-	writeDataBE(8,HT1632_CMD_LEDON,true);
-	writeDataBE(8,HT1632_CMD_BLOFF,true);
-	writeDataBE(8,HT1632_CMD_PWM+15,true);
-	releaseDisplay(displayNum);
+	uint8_t commands[] = {
+		HT1632_CMD_SYSDIS,
+		HT1632_CMD_COMS10,
+		(uint8_t)(master ? HT1632_CMD_MSTMD : HT1632_CMD_SLVMD),
+		HT1632_CMD_SYSEN,
+		HT1632_CMD_LEDON,
+		HT1632_CMD_BLOFF,
+		HT1632_CMD_PWM+15
+	};
+	sendCommands(1UL << displayNum, commands, sizeof(commands));
+	
+	if(verbose)
+	{
+		Serial.print((int)displayNum);
+		Serial.println(master ? " is Master" : " is Slave");
+	}
+	
 	clear(displayNum,true);
 }
 
+// Bring up the whole chain at once. pins holds the CS pin for each display in order
+void MatrixDisplay::initDisplays(const uint8_t* pins, uint8_t masterNum)
+{
+	for(uint8_t i=0; i<displayCount; ++i)
+	{
+		pDisplayPins[i] = pins[i];
+		pinMode(pins[i], OUTPUT);
+		bitBlast(pins[i], 1); // Disable chip (pull high)
+	}
+	
+	uint32_t all = ALL_PANELS;
+	uint32_t master = 1UL << masterNum;
+	
+	const uint8_t setup[] = { HT1632_CMD_SYSDIS, HT1632_CMD_COMS10 };
+	const uint8_t masterMode[] = { HT1632_CMD_MSTMD };
+	const uint8_t slaveMode[] = { HT1632_CMD_SLVMD };
+	const uint8_t enable[] = { HT1632_CMD_SYSEN, HT1632_CMD_LEDON, HT1632_CMD_BLOFF, HT1632_CMD_PWM+15 };
+	
+	// Four transfers, however long the chain is
+	sendCommands(all, setup, sizeof(setup));
+	sendCommands(master, masterMode, sizeof(masterMode));
+	sendCommands(all & ~master, slaveMode, sizeof(slaveMode));
+	sendCommands(all, enable, sizeof(enable));
+	
+	if(verbose)
+	{
+		Serial.print((int)masterNum);
+		Serial.println(" is Master");
+	}
+	
+	clear(true);
+}
+
+// Send a list of commands to every display in the mask (successive command mode, one preamble)
+void MatrixDisplay::sendCommands(uint32_t panelMask, const uint8_t* commands, uint8_t commandCount)
+{
+	selectDisplays(panelMask);
+	preCommand(); // Sends 100 (command mode)
+	for(uint8_t i=0; i<commandCount; ++i) writeDataBE(8, commands[i], true);
+	releaseDisplays(panelMask);
+}
+
+void MatrixDisplay::setVerbose(bool enabled)
+{
+	verbose = enabled;
+}
+
 uint8_t MatrixDisplay::getPixel(uint8_t displayNum, uint8_t x, uint8_t y, bool useShadow)
 {
-    // Encode XY to an appropriate XY address
-    uint8_t address = xyToIndex(x, y);
+	if(!useShadow && !pDisplayBuffers) return 0;
 	
+    // Encode XY to an appropriate XY address
 	// offset to the correct buffer for the display
-    address += backBufferSize * displayNum;
-    	
-
+    uint16_t address = xyToIndex(x, y) + (backBufferSize * displayNum);
     uint8_t bit = CalcBit(y);
 	
     // fetch the value byte from the buffer
-	address = (backBufferSize * displayNum) + address;
-	uint8_t value = 0;
+	uint8_t* pBuffer = useShadow ? pShadowBuffers : pDisplayBuffers;
 	
-	if(useShadow)
-	{
-		value = pShadowBuffers[address];
-	}else{
-		value = pDisplayBuffers[address];
-	}
-    
-  	
-	return (value & bit) ? 1 : 0; 
+	if(planeWidth == backBufferSize) return (pBuffer[address] & bit) ? 1 : 0; 
+	
+	// Bi-colour, one bit from each plane
+	return ((pBuffer[address] & bit) ? COLOUR_GREEN : 0) | ((pBuffer[address + planeWidth] & bit) ? COLOUR_RED : 0);
 }
 
 
 void MatrixDisplay::setPixel(uint8_t displayNum, uint8_t x, uint8_t y, uint8_t value, bool paint, bool useShadow)
 {
+	if(!useShadow && !pDisplayBuffers) return;
+	
     // calculate a pointer into the display buffer (6 bit offset)
-    uint8_t address = xyToIndex(x, y);
-	uint8_t dispAddress = address;
+    x = xyToIndex(x, y);
    
     // offset to the correct buffer for the display
-    address += backBufferSize * displayNum;	
+    uint16_t address = x + (backBufferSize * displayNum);	
     uint8_t bit = CalcBit(y);
-	
+	uint8_t* pBuffer = useShadow ? pShadowBuffers : pDisplayBuffers;
+	bool bicolour = planeWidth != backBufferSize;
 	
 	// ...and apply the value
-    if(value)
-    {
-		if(useShadow)
-		{
-			pShadowBuffers[address] |= bit;
-		}else{
-			pDisplayBuffers[address] |= bit;
-		}
-    }
-    else
-    {
-		if(useShadow)
-		{
-			pShadowBuffers[address] &= ~bit;
-		}else{
-			pDisplayBuffers[address] &= ~bit;
-		}
-    }
+	if(!bicolour)
+	{
+		if(value) pBuffer[address] |= bit;
+		else pBuffer[address] &= ~bit;
+	}
+	else
+	{
+		// Each plane gets its own bit of the colour, no branching per plane
+		pBuffer[address] = (pBuffer[address] & ~bit) | (-(value & COLOUR_GREEN) & bit);
+		pBuffer[address + planeWidth] = (pBuffer[address + planeWidth] & ~bit) | (-((value & COLOUR_RED) >> 1) & bit);
+	}
 	
     if(useShadow) return;
 	
 	if(!paint)
 	{
-		// flag the display as dirty
-		//pDisplayPins[displayNum] |= DIRTY_BIT;
+		// flag the column as dirty
+		markDirty(displayNum, x);
+		if(bicolour) markDirty(displayNum, x + planeWidth);
+	}else if(writeCombineLimit > 1){
+		// Queue it, neighbouring nybbles go out together
+		queueNibble(0, displayNum, displayXYToIndex(x, y));
+		if(bicolour) queueNibble(1, displayNum, displayXYToIndex(x + planeWidth, y));
 	}else{
-		uint8_t dispAddress = displayXYToIndex(x, y);
-	    uint8_t value = pDisplayBuffers[address];
-		if(y>=4) // Devide y by 4. Work out whether it's odd or even. 8 pixels packed into 1 byte. 16 pixels are in two bytes. We need to figure out whether to shift the buffer
+		for(uint8_t plane = 0; plane < (bicolour ? 2 : 1); ++plane)
 		{
-			value = pDisplayBuffers[address]  >> 4;
+			uint8_t col = x + (plane * planeWidth);
+			uint8_t dispAddress = displayXYToIndex(col, y);
+			uint8_t value = pDisplayBuffers[address + (plane * planeWidth)];
+			if(y>=4) // Devide y by 4. Work out whether it's odd or even. 8 pixels packed into 1 byte. 16 pixels are in two bytes. We need to figure out whether to shift the buffer
+			{
+				value >>= 4;
+			}
+		
+			writeNibbles(displayNum, dispAddress, &value, 1);
 		}
+	}
+}
+
+// Bi-colour panels hold a second (red) plane in the upper half of the chip's RAM.
+// Each plane is then 16 columns wide: bytes 0-15 of a display's buffer are green, 16-31 red.
+// A full sync still sends both planes in one successive write.
+void MatrixDisplay::setColourMode(bool bicolour)
+{
+	planeWidth = bicolour ? (backBufferSize / 2) : backBufferSize;
+}
+
+uint8_t MatrixDisplay::getPlaneCount()
+{
+	return planeWidth == backBufferSize ? 1 : 2;
+}
+
+void MatrixDisplay::setWriteCombining(uint8_t maxNibbles)
+{
+	flushWrites();
+	writeCombineLimit = maxNibbles > (backBufferSize * 2) ? (backBufferSize * 2) : maxNibbles;
+}
+
+// Send the queued ranges. The data comes from the back buffer, so it's always the latest value
+void MatrixDisplay::flushWrites()
+{
+	flushPlane(0);
+	flushPlane(1);
+}
+
+void MatrixDisplay::flushPlane(uint8_t plane)
+{
+	if(queuedDisplay[plane] < 0) return;
 	
-		writeNibbles(displayNum, dispAddress, &value, 1);
+	writeNibbleRange(queuedDisplay[plane], queuedStart[plane], queuedEnd[plane]);
+	queuedDisplay[plane] = -1;
+}
+
+void MatrixDisplay::queueNibble(uint8_t plane, uint8_t displayNum, uint8_t addr)
+{
+	int8_t& display = queuedDisplay[plane];
+	uint8_t& queueStart = queuedStart[plane];
+	uint8_t& queueEnd = queuedEnd[plane];
+	
+	if(display == (int8_t)displayNum)
+	{
+		// Already queued, it'll go out with the latest buffer contents
+		if(addr >= queueStart && addr < queueEnd) return;
+		
+		// Close enough to merge? Filling a small gap is cheaper than a new transaction
+		uint8_t start = addr < queueStart ? addr : queueStart;
+		uint8_t end = addr >= queueEnd ? addr + 1 : queueEnd;
+		bool near = (addr + 1 + WRITE_COMBINE_GAP >= queueStart) && (addr <= queueEnd + WRITE_COMBINE_GAP);
+		
+		if(near && (uint8_t)(end - start) <= writeCombineLimit)
+		{
+			queueStart = start;
+			queueEnd = end;
+			if(queueEnd - queueStart == writeCombineLimit) flushPlane(plane); // Full
+			return;
+		}
 	}
+	
+	// Not contiguous with the queue (or nothing queued), start a new run
+	flushPlane(plane);
+	display = displayNum;
+	queueStart = addr;
+	queueEnd = addr + 1;
 }
 
 void MatrixDisplay::dumpByte(uint8_t aByte)
@@ -234,36 +423,167 @@ void MatrixDisplay::dumpByte(uint8_t aByte)
 	Serial.print("\n\n");
 }
 
-// Write the backbuffer out to all displays (which have the dirty bit set!)
+// Write the backbuffer out to all displays
 void MatrixDisplay::syncDisplays() 
 {
-	uint8_t bufferOffset = 0;
-	uint8_t value  = 0;
+	if(!pDisplayBuffers) return;
+	
+	// Everything is about to be sent anyway
+	memset(queuedDisplay, -1, sizeof(queuedDisplay));
 	
     for(int8_t dispNum=0; dispNum < displayCount; ++dispNum)
     {
+		// Operating in progressive addressing mode
+		writeColumns(dispNum, 0, backBufferSize, pDisplayBuffers + (backBufferSize * dispNum));
+    }
 	
-	   // if(pDisplayPins[dispNum] & DIRTY_BIT == 0) continue;
-		
-		bufferOffset = backBufferSize * dispNum;
+	// Everything has been written, nothing left dirty
+	memset(pDirtyColumns, 0, DIRTY_BYTES * displayCount);
+	
+	if(currentBudget) limitCurrent();
+}
+
+// Write out the columns flagged by markDirty()
+void MatrixDisplay::syncDirty()
+{
+	if(!pDisplayBuffers) return;
+	
+	flushWrites();
+	
+	for(uint8_t dispNum=0; dispNum < displayCount; ++dispNum)
+	{
+		uint8_t* pDirty = pDirtyColumns + (DIRTY_BYTES * dispNum);
+		uint8_t* pBuffer = pDisplayBuffers + (backBufferSize * dispNum);
 		
-		 // flip the "dirty" bit
-		 // pDisplayPins[dispNum] ^= DIRTY_BIT;
+		uint8_t x = 0;
+		while(x < backBufferSize)
+		{
+			// Skip a whole byte of clean columns at once
+			if((x & 7) == 0 && pDirty[x >> 3] == 0)
+			{
+				x += 8;
+				continue;
+			}
+			
+			if(!(pDirty[x >> 3] & (1 << (x & 7))))
+			{
+				++x;
+				continue;
+			}
+			
+			// Found the start of a run, find the end
+			uint8_t runStart = x;
+			while(x < backBufferSize && (pDirty[x >> 3] & (1 << (x & 7)))) ++x;
+			
+			writeColumns(dispNum, runStart, x - runStart, pBuffer + runStart);
+		}
 		
-		selectDisplay(dispNum);
-		writeDataBE(3, HT1632_ID_WR); // Send "write to display" command
-		writeDataBE(7, 0); // Send initial address (aka 0)
+		memset(pDirty, 0, DIRTY_BYTES);
+	}
+	
+	if(currentBudget) limitCurrent();
+}
+
+// One run of syncDirty() per call, for spreading a sync over several passes of loop()
+// Columns flagged while a sync is part way through are picked up by the following steps
+bool MatrixDisplay::syncDirtyStep()
+{
+	if(!pDisplayBuffers) return false;
+	
+	flushWrites();
+	
+	uint8_t dispNum, start, end;
+	if(!findDirtyRun(dispNum, start, end)) return false;
+	
+	writeColumns(dispNum, start, end - start, pDisplayBuffers + (backBufferSize * dispNum) + start);
+	
+	uint8_t* pDirty = pDirtyColumns + (DIRTY_BYTES * dispNum);
+	for(uint8_t x = start; x < end; ++x) pDirty[x >> 3] &= ~(1 << (x & 7));
+	
+	if(findDirtyRun(dispNum, start, end)) return true;
+	
+	// That was the last run
+	if(currentBudget) limitCurrent();
+	return false;
+}
+
+void MatrixDisplay::syncRegion(uint16_t x0, uint16_t x1)
+{
+	if(!pDisplayBuffers) return;
+	
+	if(x0 > x1)
+	{
+		uint16_t t = x0;
+		x0 = x1;
+		x1 = t;
+	}
+	
+	uint16_t chainWidth = planeWidth * displayCount;
+	if(x0 >= chainWidth) return;
+	if(x1 >= chainWidth) x1 = chainWidth - 1;
+	
+	flushWrites();
+	
+	for(uint8_t dispNum = x0 / planeWidth; dispNum <= x1 / planeWidth; ++dispNum)
+	{
+		uint16_t panelStart = dispNum * planeWidth;
+		uint8_t first = x0 > panelStart ? x0 - panelStart : 0;
+		uint8_t last = (x1 - panelStart) < planeWidth ? x1 - panelStart : planeWidth - 1;
+		uint8_t* pBuffer = pDisplayBuffers + (backBufferSize * dispNum);
 		
-		// Operating in progressive addressing mode
-		for(int8_t addr = 0; addr < backBufferSize; ++addr) // Thought i'd simplify this a touch
+		if(first == 0 && last == planeWidth - 1)
 		{
-			value = pDisplayBuffers[addr + bufferOffset];
-            writeDataLE(8, value);  
+			// Whole display, every plane in one write
+			writeColumns(dispNum, 0, backBufferSize, pBuffer);
+			memset(pDirtyColumns + (DIRTY_BYTES * dispNum), 0, DIRTY_BYTES);
+			continue;
 		}
 		
-		releaseDisplay(dispNum);
+		// One write per colour plane
+		for(uint8_t plane = first; plane < backBufferSize; plane += planeWidth)
+		{
+			uint8_t end = plane + (last - first);
+			writeColumns(dispNum, plane, end - plane + 1, pBuffer + plane);
+			
+			// These columns are up to date now
+			uint8_t* pDirty = pDirtyColumns + (DIRTY_BYTES * dispNum);
+			for(uint8_t x = plane; x <= end; ++x) pDirty[x >> 3] &= ~(1 << (x & 7));
+		}
+	}
+	
+	if(currentBudget) limitCurrent();
+}
 
+void MatrixDisplay::syncPanel(uint8_t displayNum)
+{
+	if(displayNum >= displayCount || !pDisplayBuffers) return;
+	
+	flushWrites();
+	writeColumns(displayNum, 0, backBufferSize, pDisplayBuffers + (backBufferSize * displayNum));
+	memset(pDirtyColumns + (DIRTY_BYTES * displayNum), 0, DIRTY_BYTES);
+	
+	if(currentBudget) limitCurrent();
+}
+
+// Stream a caller's frame (back buffer layout, display n starts at byte n * 32) straight to the panels
+void MatrixDisplay::syncFrom(const uint8_t* data, bool inProgmem, uint32_t panelMask)
+{
+	flushWrites();
+	
+	for(uint8_t dispNum=0; dispNum < displayCount && dispNum < 32; ++dispNum)
+	{
+		if(!(panelMask & (1UL << dispNum))) continue;
+		
+		const uint8_t* pSource = data + (backBufferSize * dispNum);
+		writeColumns(dispNum, 0, backBufferSize, pSource, inProgmem);
+		
+		// The panel no longer shows the back buffer, the next syncDirty() puts it back
+		memset(pDirtyColumns + (DIRTY_BYTES * dispNum), 0xFF, DIRTY_BYTES);
+		
+		if(currentBudget) pLitCounts[dispNum] = countLit(pSource, inProgmem);
 	}
+	
+	if(currentBudget) limitCurrent(false);
 }
 
 void MatrixDisplay::writeNibbles(uint8_t displayNum, uint8_t addr, uint8_t* data, uint8_t nybbleCount)
@@ -273,6 +593,18 @@ void MatrixDisplay::writeNibbles(uint8_t displayNum, uint8_t addr, uint8_t* data
   writeDataBE(7,addr); // Send address
   for(int8_t i = 0; i < nybbleCount; ++i) writeDataLE(4,data[i]); // send multiples of 4 bits of data
   releaseDisplay(displayNum); // done
+  
+  if(pPanelBuffers)
+  {
+    // Track what the panel now holds
+    uint8_t* pPanel = pPanelBuffers + (backBufferSize * displayNum);
+    for(uint8_t i = 0; i < nybbleCount; ++i)
+    {
+      uint8_t a = (addr + i) & 0x3F;
+      if(a & 1) pPanel[a >> 1] = (pPanel[a >> 1] & 0x0F) | (data[i] << 4);
+      else pPanel[a >> 1] = (pPanel[a >> 1] & 0xF0) | (data[i] & 0x0F);
+    }
+  }
 }
 
 
@@ -286,20 +618,24 @@ void MatrixDisplay::clear(uint8_t displayNum, bool paint, bool useShadow)
 				backBufferSize
 			   );	
 	
-	}else{
+	}else if(pDisplayBuffers){
 		memset( pDisplayBuffers + (backBufferSize * displayNum), 
 				0, 
 				backBufferSize
 			   );
 		   
-		// Flag dirty bit
-		// pDisplayPins[displayNum] |= DIRTY_BIT;
+		// Flag every column as dirty
+		memset(pDirtyColumns + (DIRTY_BYTES * displayNum), 0xFF, DIRTY_BYTES);
 	}
 	
 
 	
-	// Write out change
-	if(paint && !useShadow) syncDisplays();
+	// Write out change (just this display)
+	if(paint && !useShadow)
+	{
+		if(pDisplayBuffers) syncPanel(displayNum);
+		else clearPanels(1UL << displayNum); // Pass-through
+	}
 }
 
 void MatrixDisplay::clear(bool paint, bool useShadow)
@@ -308,26 +644,12 @@ void MatrixDisplay::clear(bool paint, bool useShadow)
 	{
 		memset(pShadowBuffers,0, backBufferSize*displayCount);
 	}else{
-		memset(pDisplayBuffers,0, backBufferSize*displayCount);
+		if(pDisplayBuffers) memset(pDisplayBuffers,0, backBufferSize*displayCount);
+		memset(pDirtyColumns, paint ? 0 : 0xFF, DIRTY_BYTES*displayCount);
 	}
 	
 	// Select all displays and clear
-	if(paint && !useShadow)
-	{
-	
-		for(int8_t i=0; i<displayCount; ++i) selectDisplay(i); // Enable all displays
-	
-		// Use progressive write mode, faster
-		writeDataBE(3, HT1632_ID_WR); // Send "write to display" command
-		writeDataBE(7, 0); // Send initial address (aka 0)
-			
-		for(uint8_t i = 0; i<32; ++i)
-		{
-			writeDataLE(4,0xff); // Write nada
-		}
-	
-		for(int8_t i=0; i<displayCount; ++i) releaseDisplay(i); // Disable all displays
-	}
+	if(paint && !useShadow) clearPanels(ALL_PANELS);
 }
 
 
@@ -337,7 +659,7 @@ void MatrixDisplay::clear(bool paint, bool useShadow)
 inline uint8_t MatrixDisplay::xyToIndex(uint8_t x, uint8_t y)
 {
 
-    // cap X coordinate at 32 column
+    // cap X coordinate at 32 column (16 per plane on bi-colour panels)
     x &= 0x1F;
     // cap Y coordinate at 8
    // y &= 0x7;
@@ -359,6 +681,7 @@ inline void MatrixDisplay::selectDisplay(uint8_t displayNum)
 //	Serial.println(pDisplayPins[displayNum],DEC);
     bitBlast(pDisplayPins[displayNum], 0);
 	//digitalWrite(5,0); 
+	busDelay = pBusDelays[displayNum];
 }
 
 inline void MatrixDisplay::releaseDisplay(uint8_t displayNum)
@@ -370,6 +693,128 @@ inline void MatrixDisplay::releaseDisplay(uint8_t displayNum)
 }
 
 
+// Successive write of nybble addresses start up to (not including) end, straight from the back buffer
+void MatrixDisplay::writeNibbleRange(uint8_t displayNum, uint8_t start, uint8_t end)
+{
+	uint8_t* pBuffer = pDisplayBuffers + (backBufferSize * displayNum);
+	
+	selectDisplay(displayNum);
+	writeDataBE(3, HT1632_ID_WR); // Send "write to display" command
+	writeDataBE(7, start); // Successive addressing from here
+	for(uint8_t addr = start; addr < end; ++addr)
+	{
+		uint8_t value = pBuffer[addr >> 1];
+		writeDataLE(4, (addr & 1) ? (value >> 4) : value);
+	}
+	releaseDisplay(displayNum);
+	
+	if(pPanelBuffers)
+	{
+		// Keep our copy of the panel RAM in step
+		uint8_t* pPanel = pPanelBuffers + (backBufferSize * displayNum);
+		for(uint8_t addr = start; addr < end; ++addr)
+		{
+			uint8_t keep = (addr & 1) ? 0x0F : 0xF0;
+			pPanel[addr >> 1] = (pPanel[addr >> 1] & keep) | (pBuffer[addr >> 1] & ~keep);
+		}
+	}
+}
+
+// First run of flagged columns in the chain, end is exclusive
+bool MatrixDisplay::findDirtyRun(uint8_t& dispNum, uint8_t& start, uint8_t& end)
+{
+	for(dispNum=0; dispNum < displayCount; ++dispNum)
+	{
+		uint8_t* pDirty = pDirtyColumns + (DIRTY_BYTES * dispNum);
+		
+		for(uint8_t x=0; x < backBufferSize; ++x)
+		{
+			// Skip a whole byte of clean columns at once
+			if((x & 7) == 0 && pDirty[x >> 3] == 0)
+			{
+				x += 7;
+				continue;
+			}
+			if(!(pDirty[x >> 3] & (1 << (x & 7)))) continue;
+			
+			start = x;
+			while(x < backBufferSize && (pDirty[x >> 3] & (1 << (x & 7)))) ++x;
+			end = x;
+			return true;
+		}
+	}
+	return false;
+}
+
+// Zero the RAM of every display in the mask with one successive write
+void MatrixDisplay::clearPanels(uint32_t panelMask)
+{
+	selectDisplays(panelMask); // Enable all displays
+
+	// Use progressive write mode, faster
+	writeDataBE(3, HT1632_ID_WR); // Send "write to display" command
+	writeDataBE(7, 0); // Send initial address (aka 0)
+		
+	for(uint8_t i = 0; i<backBufferSize; ++i)
+	{
+		writeDataLE(8,0); // Both nybbles of every column
+	}
+
+	releaseDisplays(panelMask); // Disable all displays
+	
+	if(pPanelBuffers)
+	{
+		for(uint8_t i=0; i<displayCount && i<32; ++i)
+		{
+			if(panelMask & (1UL << i)) memset(pPanelBuffers + (backBufferSize * i), 0, backBufferSize);
+		}
+	}
+}
+
+// Progressive write starting at column x. Each column is two nybbles (rows 0-3 then 4-7)
+void MatrixDisplay::writeColumns(uint8_t displayNum, uint8_t x, uint8_t columnCount, const uint8_t* data, bool inProgmem)
+{
+	selectDisplay(displayNum);
+	writeDataBE(3, HT1632_ID_WR); // Send "write to display" command
+	writeDataBE(7, x << 1); // Send initial address (each column spans two nybble addresses)
+	if(inProgmem)
+	{
+		for(uint8_t i = 0; i < columnCount; ++i) writeDataLE(8, pgm_read_byte(data + i));
+	}
+	else
+	{
+		for(uint8_t i = 0; i < columnCount; ++i) writeDataLE(8, data[i]);
+	}
+	releaseDisplay(displayNum);
+	
+	if(pPanelBuffers)
+	{
+		uint8_t* pPanel = pPanelBuffers + (backBufferSize * displayNum) + x;
+		if(inProgmem) memcpy_P(pPanel, data, columnCount);
+		else memcpy(pPanel, data, columnCount);
+	}
+}
+void MatrixDisplay::selectDisplays(uint32_t panelMask)
+{
+	// A broadcast has to suit the slowest display in it
+	uint8_t slowest = 0;
+	for(uint8_t i=0; i<displayCount && i<32; ++i)
+	{
+		if(!(panelMask & (1UL << i))) continue;
+		selectDisplay(i);
+		if(pBusDelays[i] > slowest) slowest = pBusDelays[i];
+	}
+	busDelay = slowest;
+}
+
+void MatrixDisplay::releaseDisplays(uint32_t panelMask)
+{
+	for(uint8_t i=0; i<displayCount && i<32; ++i)
+	{
+		if(panelMask & (1UL << i)) releaseDisplay(i);
+	}
+}
+
 void MatrixDisplay::writeCommand(uint8_t displayNum, uint8_t command)
 {
     selectDisplay(displayNum);
@@ -391,7 +836,9 @@ void MatrixDisplay::writeDataLE(int8_t bitCount, uint8_t data)
     {
         bitBlast(clkPin, 0);
         bitBlast(dataPin, (data >> i) & 1);
+        busWait();
         bitBlast(clkPin, 1);
+        busWait();
     }
 }
 
@@ -405,7 +852,9 @@ void MatrixDisplay::writeDataBE(int8_t bitCount, uint8_t data, bool useNop)
     {
         bitBlast(clkPin, 0);
         bitBlast(dataPin, (data >> i) & 1);
+        busWait();
         bitBlast(clkPin, 1);
+        busWait();
     }
 	
 	if(useNop)
@@ -413,7 +862,9 @@ void MatrixDisplay::writeDataBE(int8_t bitCount, uint8_t data, bool useNop)
 		bitBlast(clkPin, 0);				//clk = 0 for data ready
 		_nop();
 		_nop();
+		busWait();
 		bitBlast(clkPin, 1);				//clk = 1 for data write into 1632
+		busWait();
 	}
 }
 
@@ -422,29 +873,96 @@ void MatrixDisplay::writeDataBE(int8_t bitCount, uint8_t data, bool useNop)
 void MatrixDisplay::preCommand()
 {
    
+	// Same stretched clock phases as writeDataBE, the delay of the selected display(s)
 	bitBlast(clkPin, 0);
     bitBlast(dataPin, 1);
 	_nop();
+	busWait();
 	
 	bitBlast(clkPin, 1);
 	_nop();
 	_nop();
+	busWait();
 	
 	bitBlast(clkPin, 0);
     bitBlast(dataPin, 0);
 	_nop();
+	busWait();
 	
 	bitBlast(clkPin, 1);
 	_nop();
 	_nop();
+	busWait();
 	
 	bitBlast(clkPin, 0);
     bitBlast(dataPin, 0);
 	_nop();
+	busWait();
 	
 	bitBlast(clkPin, 1);
 	_nop();
 	_nop();
+	busWait();
+}
+
+// Stretch a clock phase by the selected display's delay, nothing when it's 0
+inline void MatrixDisplay::busWait()
+{
+	for(uint8_t i = busDelay; i; --i) _nop();
+}
+
+// Successive read of panel RAM, one nybble per RD pulse (LSB first) into the low bits of data[]
+// Always at the slowest setting so only the write side is under test
+void MatrixDisplay::readNibbles(uint8_t displayNum, uint8_t addr, uint8_t nybbleCount, uint8_t* data)
+{
+	selectDisplay(displayNum);
+	busDelay = BUS_MAX_DELAY;
+	writeDataBE(3, HT1632_ID_RD); // Send "read from display" command
+	writeDataBE(7, addr);
+	
+	// The panel drives the data line now
+	pinMode(dataPin, INPUT);
+	for(uint8_t n = 0; n < nybbleCount; ++n)
+	{
+		uint8_t value = 0;
+		for(uint8_t i = 0; i < 4; ++i)
+		{
+			digitalWrite(rdPin, LOW); // Panel puts the bit out on the falling edge
+			busWait();
+			if(digitalRead(dataPin)) value |= 1 << i;
+			digitalWrite(rdPin, HIGH);
+			busWait();
+		}
+		data[n] = value;
+	}
+	pinMode(dataPin, OUTPUT);
+	
+	releaseDisplay(displayNum);
+}
+
+// Write every test pattern to the whole display at its current delay and read it back
+bool MatrixDisplay::testBus(uint8_t displayNum)
+{
+	uint8_t frame[BACKBUFFER_SIZE];
+	uint8_t nibbles[BACKBUFFER_SIZE * 2];
+	
+	for(uint8_t p = 0; p < BUS_PATTERN_COUNT; ++p)
+	{
+		uint8_t pattern = pgm_read_byte(&busPatterns[p]);
+		for(uint8_t x = 0; x < backBufferSize; ++x)
+		{
+			frame[x] = (p == BUS_PATTERN_COUNT - 1) ? (uint8_t)(pattern * x + p) : ((x & 1) ? ~pattern : pattern);
+		}
+		
+		writeColumns(displayNum, 0, backBufferSize, frame);
+		readNibbles(displayNum, 0, backBufferSize * 2, nibbles);
+		
+		for(uint8_t x = 0; x < backBufferSize; ++x)
+		{
+			if(nibbles[x << 1] != (frame[x] & 0x0F) || nibbles[(x << 1) + 1] != (frame[x] >> 4)) return false;
+		}
+	}
+	return true;
 }
 
 void MatrixDisplay::bitBlast(uint8_t pin, uint8_t data)
@@ -473,34 +991,493 @@ uint8_t MatrixDisplay::getDisplayHeight()
 
 uint8_t MatrixDisplay::getDisplayWidth()
 {
-	return 32;
+	return planeWidth;
 }
 
 // Copy from the display buffer to the shadow buffer (takes a snapshot)
 void MatrixDisplay::copyBuffer()
 {
-	if(pShadowBuffers==0) return;
+	if(pShadowBuffers==0 || pDisplayBuffers==0) return;
 	memcpy (pShadowBuffers, pDisplayBuffers, (backBufferSize * displayCount) );
 }
 
 void MatrixDisplay::shiftLeft()
 {
+	if(!pDisplayBuffers) return;
 	memcpy ( pDisplayBuffers, pDisplayBuffers+2, (backBufferSize * displayCount));
+	memset(pDirtyColumns, 0xFF, DIRTY_BYTES * displayCount);
 }
 
 void MatrixDisplay::shiftRight()
 {
+	if(!pDisplayBuffers) return;
 	memcpy ( pDisplayBuffers+2, pDisplayBuffers, (backBufferSize * displayCount)-2);
+	memset(pDirtyColumns, 0xFF, DIRTY_BYTES * displayCount);
+}
+
+void MatrixDisplay::shiftUp(uint8_t count)
+{
+	if(!pDisplayBuffers) return;
+	if(count > 7) count = 8;
+	uint16_t sz = backBufferSize * displayCount;
+	
+	// Row 0 is bit 0, so up is a right shift of every column
+	for(uint16_t i=0; i<sz; ++i) pDisplayBuffers[i] = count > 7 ? 0 : pDisplayBuffers[i] >> count;
+	memset(pDirtyColumns, 0xFF, DIRTY_BYTES * displayCount);
+}
+
+void MatrixDisplay::shiftDown(uint8_t count)
+{
+	if(!pDisplayBuffers) return;
+	if(count > 7) count = 8;
+	uint16_t sz = backBufferSize * displayCount;
+	
+	for(uint16_t i=0; i<sz; ++i) pDisplayBuffers[i] = count > 7 ? 0 : pDisplayBuffers[i] << count;
+	memset(pDirtyColumns, 0xFF, DIRTY_BYTES * displayCount);
+}
+
+void MatrixDisplay::shiftUp(const uint8_t* stack, uint8_t stackCount, uint8_t count)
+{
+	if(!pDisplayBuffers || count == 0 || count > 8) return;
+	
+	for(uint8_t x=0; x<backBufferSize; ++x)
+	{
+		// Work down the stack, each display takes the top rows of the one below
+		for(uint8_t i=0; i<stackCount; ++i)
+		{
+			uint8_t* pCol = pDisplayBuffers + (backBufferSize * stack[i]) + x;
+			uint8_t carry = (i + 1 < stackCount) ? pDisplayBuffers[(backBufferSize * stack[i+1]) + x] : 0;
+			*pCol = ((uint16_t)*pCol | ((uint16_t)carry << 8)) >> count;
+		}
+	}
+	
+	for(uint8_t i=0; i<stackCount; ++i) memset(pDirtyColumns + (DIRTY_BYTES * stack[i]), 0xFF, DIRTY_BYTES);
+}
+
+void MatrixDisplay::shiftDown(const uint8_t* stack, uint8_t stackCount, uint8_t count)
+{
+	if(!pDisplayBuffers || count == 0 || count > 8) return;
+	
+	for(uint8_t x=0; x<backBufferSize; ++x)
+	{
+		// Work up the stack, each display takes the bottom rows of the one above
+		for(int8_t i=stackCount-1; i>=0; --i)
+		{
+			uint8_t* pCol = pDisplayBuffers + (backBufferSize * stack[i]) + x;
+			uint8_t carry = (i > 0) ? pDisplayBuffers[(backBufferSize * stack[i-1]) + x] : 0;
+			*pCol = (((uint16_t)*pCol << 8 | carry) << count) >> 8;
+		}
+	}
+	
+	for(uint8_t i=0; i<stackCount; ++i) memset(pDirtyColumns + (DIRTY_BYTES * stack[i]), 0xFF, DIRTY_BYTES);
+}
+
+// Hacker's Delight transpose8, columns are bytes so a transpose swaps rows and columns
+void MatrixDisplay::transpose8(const uint8_t* in, uint8_t* out)
+{
+	// Column 0 is the least significant byte, row 0 the least significant bit
+	uint32_t lo = (uint32_t)in[0] | ((uint32_t)in[1] << 8) | ((uint32_t)in[2] << 16) | ((uint32_t)in[3] << 24);
+	uint32_t hi = (uint32_t)in[4] | ((uint32_t)in[5] << 8) | ((uint32_t)in[6] << 16) | ((uint32_t)in[7] << 24);
+	uint32_t t;
+	
+	// Swap 1x1 blocks, then 2x2, then 4x4
+	t = (lo ^ (lo >> 7)) & 0x00AA00AAUL; lo = lo ^ t ^ (t << 7);
+	t = (hi ^ (hi >> 7)) & 0x00AA00AAUL; hi = hi ^ t ^ (t << 7);
+	
+	t = (lo ^ (lo >> 14)) & 0x0000CCCCUL; lo = lo ^ t ^ (t << 14);
+	t = (hi ^ (hi >> 14)) & 0x0000CCCCUL; hi = hi ^ t ^ (t << 14);
+	
+	t = (lo ^ (hi << 4)) & 0xF0F0F0F0UL; lo = lo ^ t; hi = hi ^ (t >> 4);
+	
+	out[0] = lo; out[1] = lo >> 8; out[2] = lo >> 16; out[3] = lo >> 24;
+	out[4] = hi; out[5] = hi >> 8; out[6] = hi >> 16; out[7] = hi >> 24;
+}
+
+void MatrixDisplay::transposeRegion(uint8_t displayNum, uint8_t x, uint8_t blockCount)
+{
+	rotateRegion(displayNum, x, blockCount, 4); // 4 = plain transpose, see below
+}
+
+void MatrixDisplay::rotateRegion(uint8_t displayNum, uint8_t x, uint8_t blockCount, uint8_t quarterTurns)
+{
+	if(!pDisplayBuffers) return;
+	
+	uint8_t* pBuffer = pDisplayBuffers + (backBufferSize * displayNum);
+	uint8_t block[8];
+	
+	for(uint8_t b=0; b<blockCount && x + 8 <= backBufferSize; ++b, x += 8)
+	{
+		uint8_t* pBlock = pBuffer + x;
+		
+		if(quarterTurns == 2)
+		{
+			// 180 = reverse the columns and the bits in each
+			for(uint8_t i=0; i<8; ++i)
+			{
+				uint8_t v = pBlock[7 - i];
+				v = (v >> 4) | (v << 4);
+				v = ((v & 0xCC) >> 2) | ((v & 0x33) << 2);
+				block[i] = ((v & 0xAA) >> 1) | ((v & 0x55) << 1);
+			}
+			memcpy(pBlock, block, 8);
+		}
+		else if(quarterTurns != 0)
+		{
+			transpose8(pBlock, block);
+			for(uint8_t i=0; i<8; ++i)
+			{
+				if(quarterTurns == 1)
+				{
+					// Clockwise = transpose then mirror left/right
+					pBlock[i] = block[7 - i];
+				}
+				else if(quarterTurns == 3)
+				{
+					// Anti-clockwise = transpose then mirror top/bottom
+					uint8_t v = block[i];
+					v = (v >> 4) | (v << 4);
+					v = ((v & 0xCC) >> 2) | ((v & 0x33) << 2);
+					pBlock[i] = ((v & 0xAA) >> 1) | ((v & 0x55) << 1);
+				}
+				else
+				{
+					pBlock[i] = block[i];
+				}
+			}
+		}
+		
+		for(uint8_t i=0; i<8; ++i) markDirty(displayNum, x + i);
+	}
 }
 
 void MatrixDisplay::setBrightness(uint8_t dispNum, uint8_t pwmValue)
 {  
 	// Check boundaries
 	if(pwmValue > 15)  pwmValue = 15;
-	else if(pwmValue < 0) pwmValue = 0;
+	
+	// Remember what was asked for, the current limiter may send less
+	pBrightness[dispNum] = (pBrightness[dispNum] & 0xF0) | pwmValue;
+	if(currentBudget) pwmValue = limitedBrightness(dispNum);
 	
 	selectDisplay(dispNum);
 	preCommand();
 	writeDataBE(8,HT1632_CMD_PWM+pwmValue,true);
 	releaseDisplay(dispNum);
+	pBrightness[dispNum] = (pwmValue << 4) | (pBrightness[dispNum] & 0x0F);
+}
+
+uint8_t* MatrixDisplay::getBuffer(uint8_t displayNum, bool useShadow)
+{
+	if(useShadow)
+	{
+		if(pShadowBuffers==0) return NULL;
+		return pShadowBuffers + (backBufferSize * displayNum);
+	}
+	if(pDisplayBuffers==0) return NULL;
+	return pDisplayBuffers + (backBufferSize * displayNum);
+}
+
+void MatrixDisplay::markDirty(uint8_t displayNum, uint8_t x)
+{
+	x &= 0x1F;
+	pDirtyColumns[(DIRTY_BYTES * displayNum) + (x >> 3)] |= (1 << (x & 7));
+}
+
+bool MatrixDisplay::isDirty(uint8_t displayNum, uint8_t x)
+{
+	x &= 0x1F;
+	return (pDirtyColumns[(DIRTY_BYTES * displayNum) + (x >> 3)] & (1 << (x & 7))) != 0;
+}
+
+void MatrixDisplay::setGroupBrightness(uint32_t panelMask, uint8_t pwmValue)
+{
+	if(pwmValue > 15) pwmValue = 15;
+	
+	// Panels held back by the current limiter are set on their own, the rest share one transfer
+	uint32_t group = 0;
+	for(uint8_t i=0; i<displayCount && i<32; ++i)
+	{
+		if(!(panelMask & (1UL << i))) continue;
+		pBrightness[i] = (pBrightness[i] & 0xF0) | pwmValue;
+		
+		if(currentBudget && limitedBrightness(i) != pwmValue) setBrightness(i, pwmValue);
+		else
+		{
+			group |= 1UL << i;
+			pBrightness[i] = (pwmValue << 4) | pwmValue;
+		}
+	}
+	if(group == 0) return;
+	
+	// All the chips listen to the same command at once
+	uint8_t command = HT1632_CMD_PWM+pwmValue;
+	sendCommands(group, &command, 1);
+}
+
+// Keep a copy of what each panel's RAM holds, so syncChanges() can send only the nybbles that differ
+// The copy starts out assuming the panels match the back buffer
+void MatrixDisplay::trackPanelContents(bool enabled)
+{
+	uint16_t sz = backBufferSize * displayCount;
+	if(enabled && pPanelBuffers == NULL)
+	{
+		pPanelBuffers = (uint8_t *)malloc(sz);
+		if(pDisplayBuffers) memcpy(pPanelBuffers, pDisplayBuffers, sz);
+		else memset(pPanelBuffers, 0, sz);
+	}
+	else if(!enabled && pPanelBuffers)
+	{
+		free(pPanelBuffers);
+		pPanelBuffers = NULL;
+	}
+}
+
+void MatrixDisplay::setSyncCost(uint8_t _transactionBits, uint8_t _nibbleBits)
+{
+	transactionBits = _transactionBits;
+	nibbleBits = _nibbleBits ? _nibbleBits : 1;
+}
+
+unsigned long MatrixDisplay::getLastSyncBits()
+{
+	return lastSyncBits;
+}
+
+// Cost model driven sync
+// Changed nybbles come from the panel copy when we have one, otherwise from the dirty columns.
+// Runs are merged across a gap whenever sending the gap is cheaper than starting another write
+// (gap * nibbleBits <= transactionBits), which is optimal for this model as every gap is independent.
+// If the runs cost more than one full write of the display, the full write is used instead.
+void MatrixDisplay::syncChanges()
+{
+	if(!pDisplayBuffers) return;
+	
+	flushWrites();
+	lastSyncBits = 0;
+	
+	uint8_t nibbleCount = backBufferSize * 2;
+	uint16_t fullCost = transactionBits + (uint16_t)nibbleCount * nibbleBits;
+	
+	for(uint8_t dispNum=0; dispNum < displayCount; ++dispNum)
+	{
+		uint8_t* pBuffer = pDisplayBuffers + (backBufferSize * dispNum);
+		uint8_t* pDirty = pDirtyColumns + (DIRTY_BYTES * dispNum);
+		uint8_t* pPanel = pPanelBuffers ? pPanelBuffers + (backBufferSize * dispNum) : NULL;
+		
+		// One bit per nybble address
+		uint8_t changed[BACKBUFFER_SIZE / 4];
+		memset(changed, 0, sizeof(changed));
+		bool any = false;
+		
+		for(uint8_t x=0; x<backBufferSize; ++x)
+		{
+			uint8_t diff;
+			if(pPanel) diff = pBuffer[x] ^ pPanel[x];
+			else diff = (pDirty[x >> 3] & (1 << (x & 7))) ? 0xFF : 0;
+			if(diff == 0) continue;
+			
+			uint8_t addr = x << 1;
+			if(diff & 0x0F) changed[addr >> 3] |= 1 << (addr & 7);
+			if(diff & 0xF0) changed[(addr + 1) >> 3] |= 1 << ((addr + 1) & 7);
+			any = true;
+		}
+		memset(pDirty, 0, DIRTY_BYTES);
+		if(!any) continue;
+		
+		// Plan the runs
+		uint8_t runStart[BACKBUFFER_SIZE];
+		uint8_t runEnd[BACKBUFFER_SIZE];
+		uint8_t runCount = 0;
+		uint16_t cost = 0;
+		
+		for(uint8_t addr=0; addr<nibbleCount; ++addr)
+		{
+			if(!(changed[addr >> 3] & (1 << (addr & 7)))) continue;
+			
+			if(runCount && (uint16_t)(addr - runEnd[runCount-1]) * nibbleBits <= transactionBits)
+			{
+				// Cheaper to send the clean nybbles in between than to start again
+				cost += (addr + 1 - runEnd[runCount-1]) * nibbleBits;
+				runEnd[runCount-1] = addr + 1;
+			}
+			else
+			{
+				cost += transactionBits + nibbleBits;
+				runStart[runCount] = addr;
+				runEnd[runCount++] = addr + 1;
+			}
+		}
+		
+		if(cost >= fullCost)
+		{
+			writeColumns(dispNum, 0, backBufferSize, pBuffer);
+			lastSyncBits += fullCost;
+		}
+		else
+		{
+			for(uint8_t i=0; i<runCount; ++i) writeNibbleRange(dispNum, runStart[i], runEnd[i]);
+			lastSyncBits += cost;
+		}
+	}
+	
+	if(currentBudget) limitCurrent();
+}
+
+// Lit LEDs in a display's back buffer, two table lookups per column
+uint16_t MatrixDisplay::countLitPixels(uint8_t displayNum)
+{
+	if(!pDisplayBuffers) return 0;
+	return countLit(pDisplayBuffers + (backBufferSize * displayNum), false);
+}
+
+// Lit count as of the last sync (recounted on every sync while the limiter is on)
+uint16_t MatrixDisplay::getLitPixels(uint8_t displayNum)
+{
+	return pLitCounts[displayNum];
+}
+
+// The PWM level the display is really running at
+uint8_t MatrixDisplay::getAppliedBrightness(uint8_t displayNum)
+{
+	return pBrightness[displayNum] >> 4;
+}
+
+// Budget per display in lit LEDs x (PWM level + 1), e.g. 1024 = 64 LEDs at full or 128 at half. 0 turns it off
+void MatrixDisplay::setCurrentLimit(uint16_t budget)
+{
+	currentBudget = budget;
+	if(budget) limitCurrent();
+	else
+	{
+		// Put every display back to what was asked for
+		for(uint8_t i=0; i<displayCount; ++i)
+		{
+			if((pBrightness[i] >> 4) != (pBrightness[i] & 0x0F)) setBrightness(i, pBrightness[i] & 0x0F);
+		}
+	}
+}
+
+// Highest level up to the requested one which keeps the display within budget
+uint8_t MatrixDisplay::limitedBrightness(uint8_t displayNum)
+{
+	uint8_t requested = pBrightness[displayNum] & 0x0F;
+	uint16_t lit = pLitCounts[displayNum];
+	if(lit == 0) return requested;
+	
+	uint16_t allowed = currentBudget / lit; // Levels are 1 based here (PWM 0 still lights the LEDs)
+	if(allowed == 0) return 0;
+	return (allowed - 1) < requested ? (allowed - 1) : requested;
+}
+
+void MatrixDisplay::setReadPin(uint8_t pin)
+{
+	rdPin = pin;
+	if(pin == BUS_NO_PIN) return;
+	
+	pinMode(rdPin, OUTPUT);
+	digitalWrite(rdPin, HIGH);
+}
+
+uint8_t MatrixDisplay::calibrateBus(uint8_t displayNum)
+{
+	if(rdPin == BUS_NO_PIN || displayNum >= displayCount) return BUS_NOT_CALIBRATED;
+	
+	flushWrites();
+	
+	uint8_t chosen = BUS_NOT_CALIBRATED;
+	for(uint8_t delay = 0; delay <= BUS_MAX_DELAY; ++delay)
+	{
+		pBusDelays[displayNum] = delay;
+		if(!testBus(displayNum)) continue;
+		
+		// Fastest pass, back off a little for temperature and noise. A panel which keeps up with no
+		// delay has the port writes themselves as slack, so it stays at full speed
+		chosen = delay ? delay + BUS_CALIBRATION_MARGIN : 0;
+		if(chosen > BUS_MAX_DELAY) chosen = BUS_MAX_DELAY;
+		break;
+	}
+	
+	pBusDelays[displayNum] = chosen == BUS_NOT_CALIBRATED ? BUS_MAX_DELAY : chosen;
+	
+	if(verbose)
+	{
+		Serial.print((int)displayNum);
+		Serial.print(" bus delay ");
+		Serial.println((int)pBusDelays[displayNum], DEC);
+	}
+	
+	// Put back what the display should be showing
+	if(pDisplayBuffers) syncPanel(displayNum);
+	else clearPanels(1UL << displayNum);
+	
+	return chosen;
+}
+
+bool MatrixDisplay::calibrateBus()
+{
+	bool allPassed = true;
+	for(uint8_t i=0; i<displayCount; ++i)
+	{
+		if(calibrateBus(i) == BUS_NOT_CALIBRATED) allPassed = false;
+	}
+	return allPassed;
+}
+
+void MatrixDisplay::setBusDelay(uint8_t displayNum, uint8_t delay)
+{
+	if(displayNum >= displayCount) return;
+	pBusDelays[displayNum] = delay > BUS_MAX_DELAY ? BUS_MAX_DELAY : delay;
+}
+
+uint8_t MatrixDisplay::getBusDelay(uint8_t displayNum)
+{
+	return pBusDelays[displayNum];
+}
+
+// Layout: magic, display count, one delay per display. Bytes which haven't changed aren't rewritten
+void MatrixDisplay::saveBusTiming(uint16_t address)
+{
+	uint8_t* pAddress = (uint8_t*)(uintptr_t)address;
+	for(uint8_t i=0; i<displayCount + 2; ++i, ++pAddress)
+	{
+		uint8_t value = i == 0 ? BUS_EEPROM_MAGIC : (i == 1 ? displayCount : pBusDelays[i - 2]);
+		if(eeprom_read_byte(pAddress) != value) eeprom_write_byte(pAddress, value);
+	}
+}
+
+bool MatrixDisplay::loadBusTiming(uint16_t address)
+{
+	const uint8_t* pAddress = (const uint8_t*)(uintptr_t)address;
+	if(eeprom_read_byte(pAddress) != BUS_EEPROM_MAGIC || eeprom_read_byte(pAddress + 1) != displayCount) return false;
+	
+	for(uint8_t i=0; i<displayCount; ++i) setBusDelay(i, eeprom_read_byte(pAddress + 2 + i));
+	return true;
+}
+
+// Lit LEDs in one display's worth of columns
+uint16_t MatrixDisplay::countLit(const uint8_t* data, bool inProgmem)
+{
+	uint16_t count = 0;
+	for(uint8_t x=0; x<backBufferSize; ++x)
+	{
+		uint8_t value = inProgmem ? pgm_read_byte(data + x) : data[x];
+		count += pgm_read_byte(&nibbleBitCount[value & 0x0F]) + pgm_read_byte(&nibbleBitCount[value >> 4]);
+	}
+	return count;
+}
+
+// Recount (from the back buffer) and adjust any display whose level needs to change
+void MatrixDisplay::limitCurrent(bool recount)
+{
+	for(uint8_t i=0; i<displayCount; ++i)
+	{
+		if(recount && pDisplayBuffers) pLitCounts[i] = countLitPixels(i);
+		
+		uint8_t level = limitedBrightness(i);
+		if(level == (pBrightness[i] >> 4)) continue;
+		
+		uint8_t command = HT1632_CMD_PWM+level;
+		sendCommands(1UL << i, &command, 1);
+		pBrightness[i] = (level << 4) | (pBrightness[i] & 0x0F);
+	}
 }
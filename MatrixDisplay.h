@@ -30,6 +30,20 @@
 #include "HardwareSerial.h"
 
 #include "ht1632_cmd.h"
+// Every display in the chain, for the panel mask arguments (bit n = display n)
+#define ALL_PANELS 0xFFFFFFFFUL
+
+// Pixel values on bi-colour panels (see setColourMode)
+#define COLOUR_OFF     0
+#define COLOUR_GREEN   1
+#define COLOUR_RED     2
+#define COLOUR_ORANGE  3
+
+// Bus timing (see calibrateBus). Delays are extra spin loops per clock edge
+#define BUS_NO_PIN              0xFF
+#define BUS_MAX_DELAY           64
+#define BUS_NOT_CALIBRATED      0xFF
+
 // No operation ASM instruction. Forces a delay
 #define _nop() do { __asm__ __volatile__ ("nop"); } while (0)
 
@@ -39,6 +53,7 @@ private:
 	uint8_t *pShadowBuffers; // Will store the pixel data for each display
     uint8_t *pDisplayBuffers; // Will store the pixel data for each display
     uint8_t *pDisplayPins; // Will contain the pins for each CS
+	uint8_t *pDirtyColumns; // One bit per column, flags columns which need to be written out
     
 	// Associated pins
     uint8_t  dataPin;
@@ -46,6 +61,45 @@ private:
 	
     uint8_t  displayCount;
     uint8_t  backBufferSize;
+	uint8_t  planeWidth; // Columns per colour plane, backBufferSize on mono panels
+	
+	bool	verbose; // Print diagnostics over Serial
+	
+	// Write combining for paint-through setPixel, one queued run of nybble addresses per colour plane
+	// so a bi-colour pixel's green and red nybbles don't flush each other's run
+	uint8_t writeCombineLimit; // Longest run before it's flushed, 0 or 1 = off
+	int8_t	queuedDisplay[2]; // -1 = nothing queued
+	uint8_t queuedStart[2];
+	uint8_t queuedEnd[2]; // Exclusive
+	
+	void	queueNibble(uint8_t plane, uint8_t displayNum, uint8_t addr);
+	void	flushPlane(uint8_t plane);
+	
+	// Sync planner
+	uint8_t *pPanelBuffers; // What the panels currently hold (optional, see trackPanelContents)
+	uint8_t transactionBits; // Cost of starting a write (ID and address)
+	uint8_t nibbleBits; // Cost of each nybble written
+	unsigned long lastSyncBits; // What the last syncChanges() was expected to cost
+	
+	void	writeNibbleRange(uint8_t displayNum, uint8_t start, uint8_t end);
+	
+	// Current limiting
+	uint8_t *pBrightness; // Requested PWM level (low nybble), level actually set (high nybble)
+	uint16_t *pLitCounts;
+	uint16_t currentBudget; // 0 = off
+	
+	// Bus timing
+	uint8_t rdPin; // BUS_NO_PIN = no read back
+	uint8_t busDelay; // Of the display(s) selected now
+	uint8_t *pBusDelays;
+	
+	inline void busWait();
+	void	readNibbles(uint8_t displayNum, uint8_t addr, uint8_t nybbleCount, uint8_t* data);
+	bool	testBus(uint8_t displayNum);
+	
+	uint8_t limitedBrightness(uint8_t displayNum);
+	void	limitCurrent(bool recount = true);
+	uint16_t countLit(const uint8_t* data, bool inProgmem);
 	
 	// Converts a cartesian coordinate to a display index
 	uint8_t displayXYToIndex(uint8_t x, uint8_t y);
@@ -56,6 +110,10 @@ private:
 	// Enables/disables a specific display in the series
     void    selectDisplay(uint8_t displayNum);  
     void    releaseDisplay(uint8_t displayNum);
+	
+	// Enables/disables every display in the mask at once, so one transfer reaches them all
+	void	selectDisplays(uint32_t panelMask);
+	void	releaseDisplays(uint32_t panelMask);
     
 	// Todo combine methods using bitwise shift
 	// Writes data to the write MSB first
@@ -66,6 +124,15 @@ private:
     
 	// Write command to write
     void    writeCommand(uint8_t displayNum, uint8_t command);
+	
+	// Write a run of columns (2 nybbles each) using successive addressing
+	void	writeColumns(uint8_t displayNum, uint8_t x, uint8_t columnCount, const uint8_t* data, bool inProgmem = false);
+	
+	// Finds the first run of flagged columns
+	bool	findDirtyRun(uint8_t& dispNum, uint8_t& start, uint8_t& end);
+	
+	// Zero the panel RAM of every display in the mask at once
+	void	clearPanels(uint32_t panelMask);
 
 	// High speed write to write (AtMega328 only)
     void    bitBlast(uint8_t pin, uint8_t data);
@@ -85,7 +152,10 @@ public:
 	// Number of displays (1-4)
 	// Shared clock pin
 	// Shared data pin
-    MatrixDisplay(uint8_t numDisplays, uint8_t clkPin, uint8_t dataPin, bool buildShadow = false);
+	// buildBackBuffer = false is pass-through mode, frames only come from syncFrom() and the pixel,
+	// shift and sync functions do nothing. Saves 32 bytes of RAM per display. DisplayToolbox, LayerStack,
+	// Marquee, Animation and Transition draw into the back buffer, so they do nothing too
+    MatrixDisplay(uint8_t numDisplays, uint8_t clkPin, uint8_t dataPin, bool buildShadow = false, bool buildBackBuffer = true);
     
 	// Destructor
     ~MatrixDisplay();
@@ -98,6 +168,16 @@ public:
 
 	// Initalise a display
     void    initDisplay(uint8_t displayNum, uint8_t pin, bool isMaster);
+	
+	// Initalise every display in one go. pins holds each display's CS pin, masterNum is the master
+	// The slaves are configured with a single broadcast so start up doesn't grow with the chain
+	void	initDisplays(const uint8_t* pins, uint8_t masterNum = 0);
+	
+	// Send HT1632 commands (HT1632_CMD_*) to every display in the mask with one transfer
+	void	sendCommands(uint32_t panelMask, const uint8_t* commands, uint8_t commandCount);
+	
+	// Print diagnostics (master/slave etc) over Serial. Off by default, Serial is slow
+	void	setVerbose(bool enabled);
     
 	// Sync display using progressive write (Can be buggy, very fast)
     void    syncDisplays();
@@ -109,9 +189,33 @@ public:
 	// Clear all displays
 	void 	clear(bool paint = false, bool useShadow = false);
 	
+	// Merge paint-through setPixel writes into runs of up to maxNibbles (64 = whole display) sent with successive addressing
+	// Off (0) by default. When on, call flushWrites() when you need the queued pixels to appear
+	void	setWriteCombining(uint8_t maxNibbles);
+	void	flushWrites();
+	
 	// Write a single nybble to the display (the display writes 4 bits at a time min)
 	void	writeNibbles(uint8_t displayNum, uint8_t addr, uint8_t* data, uint8_t nybbleCount);
 	
+	// Bi-colour (red/green) panels. Each display becomes 16 columns wide with two planes,
+	// pixel values are then COLOUR_*. getBuffer() returns the green plane, the red one follows it
+	void	setColourMode(bool bicolour);
+	uint8_t getPlaneCount();
+	
+	// Bus calibration, needs the panels' RD line on a pin. Test patterns are written at longer and longer
+	// delays, starting from none, and read back (slowly) until they pass. Each display then runs at the
+	// fastest setting which passed plus a margin of 2, or at 0 if it passed with no delay at all.
+	// Returns the delay chosen or BUS_NOT_CALIBRATED (the slowest is kept).
+	// The display contents are rewritten from the back buffer afterwards
+	void	setReadPin(uint8_t pin);
+	uint8_t calibrateBus(uint8_t displayNum);
+	bool	calibrateBus(); // Every display, false if any failed
+	void	setBusDelay(uint8_t displayNum, uint8_t delay);
+	uint8_t getBusDelay(uint8_t displayNum);
+	// Keep the calibration in EEPROM (2 + 1 byte per display from address), load returns false if there's none
+	void	saveBusTiming(uint16_t address);
+	bool	loadBusTiming(uint16_t address);
+	
 	// Helper functions
 	uint8_t getDisplayCount();
 	
@@ -126,9 +230,75 @@ public:
 	void	shiftLeft();
 	void	shiftRight();
 	
+	// Shift every display Up|Down by count rows, rows pushed off the edge are lost
+	void	shiftUp(uint8_t count = 1);
+	void	shiftDown(uint8_t count = 1);
+	
+	// Shift a stack of displays (listed top to bottom) as one tall display, rows carry across
+	void	shiftUp(const uint8_t* stack, uint8_t stackCount, uint8_t count = 1);
+	void	shiftDown(const uint8_t* stack, uint8_t stackCount, uint8_t count = 1);
+	
+	// 8x8 bit matrix transpose, in and out are 8 columns in the buffer layout (may not overlap)
+	static void transpose8(const uint8_t* in, uint8_t* out);
+	
+	// Transpose/rotate square 8x8 blocks in place, starting at column x for blockCount blocks
+	// quarterTurns is clockwise (1 = 90, 2 = 180, 3 = 270)
+	void	transposeRegion(uint8_t displayNum, uint8_t x, uint8_t blockCount = 1);
+	void	rotateRegion(uint8_t displayNum, uint8_t x, uint8_t blockCount, uint8_t quarterTurns);
+	
 	// Set PWN brightness
 	void	setBrightness(uint8_t dispNum, uint8_t pwmValue);
 	
+	// Set PWM brightness on a group of displays with a single command transfer
+	void	setGroupBrightness(uint32_t panelMask, uint8_t pwmValue);
+	
+	// Count the lit LEDs of a display's back buffer
+	uint16_t countLitPixels(uint8_t displayNum);
+	
+	// Keep each display under a budget of lit LEDs x (PWM level + 1) by lowering its brightness.
+	// Checked on every sync, the level asked for with setBrightness is restored when there's room. 0 = off
+	void	setCurrentLimit(uint16_t budget);
+	uint16_t getLitPixels(uint8_t displayNum); // As of the last sync
+	uint8_t getAppliedBrightness(uint8_t displayNum);
+	
+	// Direct access to the packed buffer of one display (one byte per column, bit 0 is the top row)
+	// Returns NULL when asking for a shadow buffer which wasn't built, or in pass-through mode
+	uint8_t* getBuffer(uint8_t displayNum, bool useShadow = false);
+	
+	// Flag a column as changed so syncDirty() will write it out
+	void	markDirty(uint8_t displayNum, uint8_t x);
+	bool	isDirty(uint8_t displayNum, uint8_t x);
+	
+	// Write out only the flagged columns, each contiguous run as one progressive write
+	void	syncDirty();
+	
+	// Write out a single run of flagged columns, returns true while more are waiting.
+	// Lets a sync be spread over several passes of loop(), see TaskRunner
+	bool	syncDirtyStep();
+	
+	// Write out columns x0 to x1 (inclusive) of the whole chain, display 0 starts at column 0
+	// Each display in the range gets one progressive write covering just its part
+	void	syncRegion(uint16_t x0, uint16_t x1);
+	
+	// Write out a single display
+	void	syncPanel(uint8_t displayNum);
+	
+	// Write a frame held by the caller (RAM or PROGMEM, in the back buffer layout) to the displays in
+	// the mask without touching the back buffer. Their columns are flagged dirty so syncDirty() restores them
+	void	syncFrom(const uint8_t* data, bool inProgmem = false, uint32_t panelMask = ALL_PANELS);
+	
+	// Write out what changed, choosing per display between one full write and runs of nybbles
+	// using a bit cost model. Run gaps are filled when that's cheaper than another write
+	void	syncChanges();
+	// Keep a copy of the panels' RAM so syncChanges() can diff per nybble (costs another buffer)
+	void	trackPanelContents(bool enabled);
+	// Tune the model: clocked bits to start a write (ID and address, default 10) and per nybble
+	// (default 4). Add a little to transactionBits to account for toggling chip select
+	void	setSyncCost(uint8_t transactionBits, uint8_t nibbleBits);
+	// Clocked bits the last syncChanges() planned for. With the default costs this is the number
+	// of clock edges it sent
+	unsigned long getLastSyncBits();
+	
 	
 };
 
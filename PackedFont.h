@@ -0,0 +1,45 @@
+/*
+	MatrixDisplay Library 2.0
+	Author: Miles Burton, www.milesburton.com/
+	Need a 16x24 display? Check out www.mnethardware.co.uk
+	Copyright (c) 2010 Miles Burton All Rights Reserved
+
+	This library is free software; you can redistribute it and/or
+	modify it under the terms of the GNU Lesser General Public
+	License as published by the Free Software Foundation; either
+	version 2.1 of the License, or (at your option) any later version.
+
+	This library is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+	Lesser General Public License for more details.
+
+	You should have received a copy of the GNU Lesser General Public
+	License along with this library; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#ifndef PACKED_FONT_GUARD
+#define PACKED_FONT_GUARD
+
+#include <inttypes.h>
+
+/*
+Proportional font packed the same way as the display buffer: one byte per column, bit 0 is
+the top row, so glyphs can be copied straight into a column without testing each pixel.
+
+Only the range firstChar to lastChar is stored. All the arrays live in PROGMEM, the struct
+itself is small enough to keep in RAM. Generate these with tools/fontc from a BDF or PSF font.
+*/
+struct PackedFont
+{
+	uint8_t firstChar;
+	uint8_t lastChar;
+	uint8_t height; // Rows, 8 at most
+	uint8_t spacing; // Blank columns between glyphs
+	const uint8_t* widths; // Columns in each glyph
+	const uint16_t* offsets; // Where each glyph starts in columns
+	const uint8_t* columns;
+};
+
+#endif
@@ -0,0 +1,125 @@
+/*
+	MatrixDisplay Library 2.0
+	Author: Miles Burton, www.milesburton.com/
+	Need a 16x24 display? Check out www.mnethardware.co.uk
+	Copyright (c) 2010 Miles Burton All Rights Reserved
+
+	This library is free software; you can redistribute it and/or
+	modify it under the terms of the GNU Lesser General Public
+	License as published by the Free Software Foundation; either
+	version 2.1 of the License, or (at your option) any later version.
+
+	This library is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+	Lesser General Public License for more details.
+
+	You should have received a copy of the GNU Lesser General Public
+	License along with this library; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#ifndef STATIC_LABEL_GUARD
+#define STATIC_LABEL_GUARD
+
+#include <inttypes.h>
+#include <avr/pgmspace.h>
+#include "font.h"
+
+/*
+Labels and small bitmaps rasterized by the compiler, so drawing one at runtime is a single blit.
+
+	STATIC_LABEL(tempLabel, "TEMP");
+	toolbox.drawBitmap(0, 0, tempLabel, sizeof(tempLabel), 8, ROP_COPY, true);
+
+	STATIC_BITMAP(degree, 3,
+		".#."
+		"#.#"
+		".#.");
+	toolbox.drawBitmap(26, 0, degree, sizeof(degree), 3, ROP_COPY, true);
+
+Labels use the font.h glyphs with one blank column between characters, the same layout Marquee
+gives a fixed font. Bitmaps are rows of '#' (lit) and anything else (off), top row first. Either
+way the result is a PROGMEM array in the buffer layout (one byte per column, bit 0 at the top)
+exactly as wide as the artwork, identical to packing it by hand. The font itself isn't stored
+unless something else reads it at runtime.
+
+Needs C++11 (constexpr), e.g. Arduino 1.6.6 or later. Older compilers skip this header.
+*/
+
+#if __cplusplus >= 201103L
+
+namespace StaticLabel
+{
+	// Compile time 0..N-1, one template argument per column
+	template<unsigned... I> struct Indices {};
+	template<unsigned N, unsigned... I> struct MakeIndices : MakeIndices<N - 1, N - 1, I...> {};
+	template<unsigned... I> struct MakeIndices<0, I...> { typedef Indices<I...> type; };
+	
+	constexpr unsigned length(const char* s)
+	{
+		return *s ? 1 + length(s + 1) : 0;
+	}
+	
+	// font.h columns have the top row in the MSB
+	constexpr uint8_t reverse(uint8_t v)
+	{
+		return ((v & 0x01) << 7) | ((v & 0x02) << 5) | ((v & 0x04) << 3) | ((v & 0x08) << 1) |
+			   ((v & 0x10) >> 1) | ((v & 0x20) >> 3) | ((v & 0x40) >> 5) | ((v & 0x80) >> 7);
+	}
+	
+	// Labels, 5 glyph columns + 1 blank per character, no blank after the last one
+	constexpr unsigned labelWidth(const char* text)
+	{
+		return length(text) ? length(text) * 6 - 1 : 0;
+	}
+	
+	constexpr uint8_t glyphColumn(uint8_t c, unsigned col)
+	{
+		return (col >= 5 || c >= 127) ? 0 : reverse(myfont[c][col]);
+	}
+	
+	constexpr uint8_t labelColumn(const char* text, unsigned x)
+	{
+		return glyphColumn((uint8_t)text[x / 6], x % 6);
+	}
+	
+	// Bitmaps, width columns by however many rows the art holds (8 at most)
+	constexpr uint8_t bitmapColumn(const char* art, unsigned width, unsigned x, unsigned y = 0)
+	{
+		return (y >= 8 || (y * width) + x >= length(art)) ? 0 :
+			(uint8_t)(((art[(y * width) + x] == '#') ? (1 << y) : 0) | bitmapColumn(art, width, x, y + 1));
+	}
+	
+	// Source supplies the text as a constexpr str(), the array is instantiated once per label
+	template<class Source, class Columns> struct Label;
+	template<class Source, unsigned... I> struct Label<Source, Indices<I...> >
+	{
+		static const uint8_t columns[sizeof...(I)];
+	};
+	template<class Source, unsigned... I>
+	const uint8_t Label<Source, Indices<I...> >::columns[sizeof...(I)] PROGMEM = { labelColumn(Source::str(), I)... };
+	
+	template<class Source, class Columns> struct Bitmap;
+	template<class Source, unsigned... I> struct Bitmap<Source, Indices<I...> >
+	{
+		static const uint8_t columns[sizeof...(I)];
+	};
+	template<class Source, unsigned... I>
+	const uint8_t Bitmap<Source, Indices<I...> >::columns[sizeof...(I)] PROGMEM = { bitmapColumn(Source::str(), sizeof...(I), I)... };
+}
+
+// Declares name as a reference to the PROGMEM columns, sizeof(name) is the width
+#define STATIC_LABEL(name, text) \
+	struct name##_Source { static constexpr const char* str() { return text; } }; \
+	static const uint8_t (&name)[StaticLabel::labelWidth(text)] = \
+		StaticLabel::Label<name##_Source, StaticLabel::MakeIndices<StaticLabel::labelWidth(text)>::type>::columns
+
+#define STATIC_BITMAP(name, width, art) \
+	struct name##_Source { static constexpr const char* str() { return art; } }; \
+	static const uint8_t (&name)[width] = \
+		StaticLabel::Bitmap<name##_Source, StaticLabel::MakeIndices<width>::type>::columns
+
+#endif
+
+#endif
@@ -0,0 +1,153 @@
+/*
+	MatrixDisplay Library 2.0
+	Author: Miles Burton, www.milesburton.com/
+	Need a 16x24 display? Check out www.mnethardware.co.uk
+	Copyright (c) 2010 Miles Burton All Rights Reserved
+
+	This library is free software; you can redistribute it and/or
+	modify it under the terms of the GNU Lesser General Public
+	License as published by the Free Software Foundation; either
+	version 2.1 of the License, or (at your option) any later version.
+
+	This library is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+	Lesser General Public License for more details.
+
+	You should have received a copy of the GNU Lesser General Public
+	License along with this library; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+
+#include "TaskRunner.h"
+
+///////////////////////////////////////////////////////////////////////////////
+//  CTORS & DTOR
+//
+TaskRunner::TaskRunner()
+	: taskCount(0)
+#if defined(ARDUINO)
+	, clock(micros)
+#else
+	, clock(NULL)
+#endif
+	, deadline(0)
+{
+	resetStats();
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//  PUBLIC FUNCTIONS
+//
+void TaskRunner::setClock(ClockSource source)
+{
+	clock = source;
+}
+
+int8_t TaskRunner::addTask(TaskFunction task, unsigned long budget)
+{
+	if(taskCount >= TASK_MAX_TASKS) return -1;
+	
+	Task& t = tasks[taskCount];
+	t.run = task;
+	t.budget = budget;
+	t.worstRun = 0;
+	t.overruns = 0;
+	t.enabled = true;
+	t.pending = false;
+	
+	return taskCount++;
+}
+
+void TaskRunner::setBudget(int8_t id, unsigned long budget)
+{
+	if(id < 0 || id >= taskCount) return;
+	tasks[id].budget = budget;
+}
+
+void TaskRunner::setEnabled(int8_t id, bool enabled)
+{
+	if(id < 0 || id >= taskCount) return;
+	tasks[id].enabled = enabled;
+	if(!enabled) tasks[id].pending = false;
+}
+
+void TaskRunner::run()
+{
+	if(!clock) return; // No time source (host build without setClock)
+	unsigned long passStart = clock();
+	
+	for(uint8_t i=0; i<taskCount; ++i)
+	{
+		Task& t = tasks[i];
+		if(!t.enabled) continue;
+		
+		unsigned long start = clock();
+		deadline = start + t.budget;
+		t.pending = t.run(this);
+		
+		unsigned long elapsed = clock() - start;
+		if(elapsed > t.worstRun) t.worstRun = elapsed;
+		if(elapsed > t.budget) ++t.overruns;
+	}
+	
+	unsigned long passTime = clock() - passStart;
+	if(passTime > worstPass) worstPass = passTime;
+	++passCount;
+}
+
+// Signed compare so micros() rollover is harmless
+bool TaskRunner::timeLeft()
+{
+	return (long)(clock() - deadline) < 0;
+}
+
+bool TaskRunner::isPending(int8_t id)
+{
+	if(id < 0 || id >= taskCount) return false;
+	return tasks[id].pending;
+}
+
+bool TaskRunner::isIdle()
+{
+	for(uint8_t i=0; i<taskCount; ++i)
+	{
+		if(tasks[i].pending) return false;
+	}
+	return true;
+}
+
+unsigned long TaskRunner::getWorstRun(int8_t id)
+{
+	if(id < 0 || id >= taskCount) return 0;
+	return tasks[id].worstRun;
+}
+
+unsigned long TaskRunner::getOverruns(int8_t id)
+{
+	if(id < 0 || id >= taskCount) return 0;
+	return tasks[id].overruns;
+}
+
+unsigned long TaskRunner::getPassCount()
+{
+	return passCount;
+}
+
+unsigned long TaskRunner::getWorstPass()
+{
+	return worstPass;
+}
+
+void TaskRunner::resetStats()
+{
+	passCount = 0;
+	worstPass = 0;
+	for(uint8_t i=0; i<taskCount; ++i)
+	{
+		tasks[i].worstRun = 0;
+		tasks[i].overruns = 0;
+	}
+}
@@ -0,0 +1,100 @@
+/*
+	MatrixDisplay Library 2.0
+	Author: Miles Burton, www.milesburton.com/
+	Need a 16x24 display? Check out www.mnethardware.co.uk
+	Copyright (c) 2010 Miles Burton All Rights Reserved
+
+	This library is free software; you can redistribute it and/or
+	modify it under the terms of the GNU Lesser General Public
+	License as published by the Free Software Foundation; either
+	version 2.1 of the License, or (at your option) any later version.
+
+	This library is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+	Lesser General Public License for more details.
+
+	You should have received a copy of the GNU Lesser General Public
+	License along with this library; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#ifndef TASK_RUNNER_GUARD
+#define TASK_RUNNER_GUARD
+
+#include <inttypes.h>
+#include <stdlib.h>
+#include "FrameScheduler.h"
+
+/*
+Round robin cooperative tasks, each with a time budget per pass of loop().
+
+A task does a slice of its work and returns, keeping whatever state it needs to carry on next time
+(a parser state, a sync cursor, the next frame due). Inside the task, check timeLeft() between
+small units of work and return when it says no. run() calls every enabled task once in the order
+they were added, so the time one loop() pass takes (and so the latency from a byte arriving to it
+being handled) is bounded by the sum of the budgets plus one unit of work per task.
+
+Typical tasks: incremental serial parsing, Animation::update(), MatrixDisplay::syncDirtyStep().
+The clock is pluggable like FrameScheduler's, budgets are in its units (microseconds). Off the
+Arduino run() does nothing until setClock() is called.
+*/
+
+#define TASK_MAX_TASKS 6
+
+class TaskRunner;
+
+// Returns true while there's work left over for the next pass
+typedef bool (*TaskFunction)(TaskRunner* runner);
+
+class TaskRunner
+{
+private:
+	struct Task
+	{
+		TaskFunction run;
+		unsigned long budget;
+		unsigned long worstRun;
+		unsigned long overruns; // Runs which went past the budget
+		bool enabled;
+		bool pending;
+	};
+	
+	Task tasks[TASK_MAX_TASKS];
+	uint8_t taskCount;
+	ClockSource clock;
+	
+	unsigned long deadline; // Of the task running now
+	unsigned long passCount;
+	unsigned long worstPass;
+	
+public:
+	// Constructor
+	TaskRunner();
+	
+	void setClock(ClockSource source);
+	
+	// Returns the task's id, or -1 when all TASK_MAX_TASKS are taken
+	int8_t addTask(TaskFunction task, unsigned long budget);
+	void setBudget(int8_t id, unsigned long budget);
+	void setEnabled(int8_t id, bool enabled);
+	
+	// Call from loop(), one slice of every task
+	void run();
+	
+	// For use inside a task, false once its budget is spent
+	bool timeLeft();
+	
+	// Did the task have work left after its last slice?
+	bool isPending(int8_t id);
+	bool isIdle(); // Nothing pending anywhere
+	
+	// Statistics
+	unsigned long getWorstRun(int8_t id);
+	unsigned long getOverruns(int8_t id);
+	unsigned long getPassCount();
+	unsigned long getWorstPass(); // Longest run(), the worst case latency between passes
+	void resetStats();
+};
+
+#endif
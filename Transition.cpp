@@ -0,0 +1,220 @@
+/*
+	MatrixDisplay Library 2.0
+	Author: Miles Burton, www.milesburton.com/
+	Need a 16x24 display? Check out www.mnethardware.co.uk
+	Copyright (c) 2010 Miles Burton All Rights Reserved
+
+	This library is free software; you can redistribute it and/or
+	modify it under the terms of the GNU Lesser General Public
+	License as published by the Free Software Foundation; either
+	version 2.1 of the License, or (at your option) any later version.
+
+	This library is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+	Lesser General Public License for more details.
+
+	You should have received a copy of the GNU Lesser General Public
+	License along with this library; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+
+#include "Transition.h"
+
+// Order the dissolve visits a display's 256 pixels in, column * 8 + row
+static const uint8_t PROGMEM dissolveOrder[256] = {
+	 61, 231,   8, 212, 143, 254,  91, 196, 148, 208, 152, 133, 136, 130, 116,  42,
+	185,  24, 207, 140, 108, 167,  23,  67,   2,  86, 129,  18,  19,  13, 147, 239,
+	 22, 159, 188,  93, 127,  34, 150, 114, 229,  31, 192, 122, 144,  50, 163, 135,
+	 37,  81, 155,  72, 209, 146, 153, 253,  87,  75,  48, 105, 190, 240, 145,  60,
+	217, 175, 106, 102,  95, 138,  65, 154, 222,  38,  59, 220,  41,  35,  55,  70,
+	 73,  40,  62,  53, 216, 195, 238,  89, 149,  98,  36,   6,  97, 174, 211,  25,
+	139, 131, 198,  63,  27, 200, 223,  15, 246, 113,  30, 215,  56,  32,  39, 161,
+	237,  99,  80, 250, 178, 119, 249, 233, 103,  58,  88, 118, 202, 173,  69, 219,
+	151, 123, 183, 251,  44, 245, 115,  11,  79,  46, 243, 181, 191, 126, 189, 110,
+	  0,  29, 120,  78,  14,  66, 248, 218, 194,  16, 117, 227, 137, 214, 210,  92,
+	228, 186, 134, 235, 142, 252,  76, 206, 160, 179, 230,  21,   1, 204, 255,  10,
+	234, 241, 225,  49,  57, 180,   7, 182, 156,  74,  52, 232, 247, 201, 112, 221,
+	 28,  83, 224, 100,  94,  17, 128, 104, 177, 141, 236, 203, 170, 125, 172, 162,
+	169, 111, 166, 205,  68, 242,   3, 197,  12,  54,  26, 164, 171,  64, 165, 107,
+	  4, 226, 121,  51,  47,   9, 187,  20,  71, 168, 199,  85, 193,  43, 132, 157,
+	 82,  96, 176,  77, 124,  84,  90, 184, 109,  45,   5, 213,  33, 158, 244, 101
+};
+
+#define DEFAULT_DISSOLVE_RATE 16
+
+///////////////////////////////////////////////////////////////////////////////
+//  CTORS & DTOR
+//
+Transition::Transition(MatrixDisplay* _disp)
+	: disp(_disp)
+	, target(NULL)
+	, targetInProgmem(false)
+	, effect(TRANSITION_WIPE)
+	, position(0)
+	, stepCount(0)
+	, dissolveRate(DEFAULT_DISSOLVE_RATE)
+	, running(false)
+{
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//  PUBLIC FUNCTIONS
+//
+void Transition::start(uint8_t _effect, const uint8_t* _target, bool inProgmem)
+{
+	effect = _effect;
+	target = _target;
+	targetInProgmem = inProgmem;
+	position = 0;
+	
+	uint16_t chainWidth = (uint16_t)disp->getDisplayWidth() * disp->getDisplayCount();
+	switch(effect)
+	{
+	case TRANSITION_DISSOLVE: stepCount = 256; break; // Counted in pixels of the order, see step()
+	case TRANSITION_BLINDS:   stepCount = TRANSITION_SLAT_HEIGHT; break;
+	default:                  stepCount = chainWidth; break;
+	}
+	
+	// Pass-through displays have no back buffer to transition in
+	running = target != NULL && disp->getBuffer(0) != NULL;
+}
+
+bool Transition::step()
+{
+	if(!running) return false;
+	
+	uint16_t chainWidth = (uint16_t)disp->getDisplayWidth() * disp->getDisplayCount();
+	
+	switch(effect)
+	{
+	case TRANSITION_WIPE:
+		mergeColumn(position, 0xFF);
+		break;
+		
+	case TRANSITION_SLIDE:
+		slideColumns();
+		break;
+		
+	case TRANSITION_DISSOLVE:
+		{
+			// The same slice of the order on every display, a whole byte's worth of planes per pixel
+			// position counts pixels of the order, so setDissolveRate() can change the rate mid-way
+			uint16_t first = position;
+			uint16_t last = first + dissolveRate > 256 ? 256 : first + dissolveRate;
+			uint8_t bufferSize = disp->getDisplayWidth() * disp->getPlaneCount();
+			for(uint8_t dispNum=0; dispNum < disp->getDisplayCount(); ++dispNum)
+			{
+				for(uint16_t i = first; i < last; ++i)
+				{
+					uint8_t pixel = pgm_read_byte(&dissolveOrder[i]);
+					uint8_t index = pixel >> 3;
+					if(index >= bufferSize) continue;
+					
+					uint8_t bit = 1 << (pixel & 7);
+					uint8_t value = disp->getBuffer(dispNum)[index];
+					writeByte(dispNum, index, (value & ~bit) | (targetByte(dispNum, index) & bit));
+				}
+			}
+			position = last - 1; // The ++ below makes it last
+		}
+		break;
+		
+	case TRANSITION_BLINDS:
+		{
+			// Row position of every slat
+			uint8_t mask = 0;
+			for(uint8_t y = position; y < 8; y += TRANSITION_SLAT_HEIGHT) mask |= 1 << y;
+			for(uint16_t x = 0; x < chainWidth; ++x) mergeColumn(x, mask);
+		}
+		break;
+	}
+	
+	if(++position >= stepCount) running = false;
+	return running;
+}
+
+void Transition::finish()
+{
+	if(!running) return;
+	
+	uint16_t chainWidth = (uint16_t)disp->getDisplayWidth() * disp->getDisplayCount();
+	for(uint16_t x = 0; x < chainWidth; ++x) mergeColumn(x, 0xFF);
+	running = false;
+}
+
+bool Transition::isRunning()
+{
+	return running;
+}
+
+void Transition::setDissolveRate(uint8_t pixelsPerStep)
+{
+	dissolveRate = pixelsPerStep ? pixelsPerStep : 1;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//  PRIVATE FUNCTIONS
+//
+uint8_t Transition::targetByte(uint8_t dispNum, uint8_t index)
+{
+	const uint8_t* p = target + ((uint16_t)disp->getDisplayWidth() * disp->getPlaneCount() * dispNum) + index;
+	return targetInProgmem ? pgm_read_byte(p) : *p;
+}
+
+// Only changed bytes are flagged, so unchanged columns cost nothing to sync
+void Transition::writeByte(uint8_t dispNum, uint8_t index, uint8_t value)
+{
+	uint8_t* pCol = disp->getBuffer(dispNum) + index;
+	if(*pCol == value) return;
+	
+	*pCol = value;
+	disp->markDirty(dispNum, index);
+}
+
+void Transition::mergeColumn(uint16_t x, uint8_t mask)
+{
+	uint8_t planeWidth = disp->getDisplayWidth();
+	uint8_t dispNum = x / planeWidth;
+	uint8_t col = x - (dispNum * planeWidth);
+	
+	for(uint8_t plane = 0; plane < disp->getPlaneCount(); ++plane, col += planeWidth)
+	{
+		uint8_t value = disp->getBuffer(dispNum)[col];
+		writeByte(dispNum, col, (value & ~mask) | (targetByte(dispNum, col) & mask));
+	}
+}
+
+// Everything moves one column left, the next target column comes in at the right edge
+void Transition::slideColumns()
+{
+	uint8_t planeWidth = disp->getDisplayWidth();
+	uint16_t chainWidth = (uint16_t)planeWidth * disp->getDisplayCount();
+	
+	for(uint8_t plane = 0; plane < disp->getPlaneCount(); ++plane)
+	{
+		uint16_t offset = plane * planeWidth;
+		for(uint16_t x = 0; x < chainWidth; ++x)
+		{
+			// Column x takes what's in x + 1, past the old frame it's the target's columns in order
+			uint16_t from = x + 1;
+			uint8_t value;
+			if(from < chainWidth)
+			{
+				uint8_t fromDisp = from / planeWidth;
+				value = disp->getBuffer(fromDisp)[from - (fromDisp * planeWidth) + offset];
+			}
+			else
+			{
+				uint8_t targetDisp = position / planeWidth;
+				value = targetByte(targetDisp, position - (targetDisp * planeWidth) + offset);
+			}
+			
+			uint8_t dispNum = x / planeWidth;
+			writeByte(dispNum, x - (dispNum * planeWidth) + offset, value);
+		}
+	}
+}
@@ -0,0 +1,89 @@
+/*
+	MatrixDisplay Library 2.0
+	Author: Miles Burton, www.milesburton.com/
+	Need a 16x24 display? Check out www.mnethardware.co.uk
+	Copyright (c) 2010 Miles Burton All Rights Reserved
+
+	This library is free software; you can redistribute it and/or
+	modify it under the terms of the GNU Lesser General Public
+	License as published by the Free Software Foundation; either
+	version 2.1 of the License, or (at your option) any later version.
+
+	This library is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+	Lesser General Public License for more details.
+
+	You should have received a copy of the GNU Lesser General Public
+	License along with this library; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#ifndef TRANSITION_GUARD
+#define TRANSITION_GUARD
+
+#include <inttypes.h>
+#include <string.h>
+#include <stdlib.h>
+#include <avr/pgmspace.h>
+#include <MatrixDisplay.h>
+
+/*
+Moves the back buffer to a target frame a step at a time instead of clear() and redraw.
+
+The target is a whole frame in the back buffer layout (32 bytes per display, RAM or PROGMEM, e.g.
+from imgconv or a buffer drawn off screen). Each step() does byte operations on the columns
+involved and flags only the ones whose value changed, so a step never costs more to sync than
+a normal frame. Call disp.syncDirty() after each step.
+
+	TRANSITION_WIPE     the target is uncovered one column per step, left to right
+	TRANSITION_SLIDE    the target pushes the old frame out to the left, one column per step
+	TRANSITION_DISSOLVE pixels switch over in a fixed random order, setDissolveRate() per step
+	TRANSITION_BLINDS   rows switch over in slats of TRANSITION_SLAT_HEIGHT, one row of each per step
+
+On bi-colour panels both planes of a column move together.
+*/
+
+#define TRANSITION_WIPE      0
+#define TRANSITION_SLIDE     1
+#define TRANSITION_DISSOLVE  2
+#define TRANSITION_BLINDS    3
+
+#define TRANSITION_SLAT_HEIGHT 4
+
+class Transition
+{
+private:
+	MatrixDisplay* disp;
+	
+	const uint8_t* target;
+	bool targetInProgmem;
+	uint8_t effect;
+	uint16_t position; // Steps taken, pixels of the order done for a dissolve
+	uint16_t stepCount;
+	uint8_t dissolveRate; // Pixels per display per step
+	bool running;
+	
+	uint8_t targetByte(uint8_t dispNum, uint8_t index);
+	void writeByte(uint8_t dispNum, uint8_t index, uint8_t value);
+	// Copy the target bits in mask into every plane of chain column x
+	void mergeColumn(uint16_t x, uint8_t mask);
+	void slideColumns();
+	
+public:	
+	// Constructor
+	Transition(MatrixDisplay* disp);
+	
+	void start(uint8_t effect, const uint8_t* target, bool inProgmem = false);
+	// Take one step, returns false once the back buffer matches the target
+	bool step();
+	// Jump to the end
+	void finish();
+	bool isRunning();
+	
+	// Dissolve speed, pixels per display per step (default 16, 16 steps). Takes effect from the next step,
+	// also during a dissolve
+	void setDissolveRate(uint8_t pixelsPerStep);
+};
+
+#endif
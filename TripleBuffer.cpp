@@ -0,0 +1,118 @@
+/*
+	MatrixDisplay Library 2.0
+	Author: Miles Burton, www.milesburton.com/
+	Need a 16x24 display? Check out www.mnethardware.co.uk
+	Copyright (c) 2010 Miles Burton All Rights Reserved
+
+	This library is free software; you can redistribute it and/or
+	modify it under the terms of the GNU Lesser General Public
+	License as published by the Free Software Foundation; either
+	version 2.1 of the License, or (at your option) any later version.
+
+	This library is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+	Lesser General Public License for more details.
+
+	You should have received a copy of the GNU Lesser General Public
+	License along with this library; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+
+#include "TripleBuffer.h"
+
+#if defined(__AVR__)
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#endif
+
+#define TRIPLE_BUFFER_FRESH 0x80
+#define TRIPLE_BUFFER_INDEX 0x03
+
+///////////////////////////////////////////////////////////////////////////////
+//  CTORS & DTOR
+//
+TripleBuffer::TripleBuffer(uint16_t _frameSize)
+	: pFrames(NULL)
+	, frameSize(_frameSize)
+	, writeIndex(0)
+	, readIndex(1)
+	, middle(2)
+{
+	pFrames = (uint8_t *)malloc(frameSize * 3);
+	memset(pFrames, 0, frameSize * 3);
+}
+
+// Destructor
+TripleBuffer::~TripleBuffer()
+{
+	if(pFrames)
+	{
+		free(pFrames);
+		pFrames = NULL;
+	}
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//  PUBLIC FUNCTIONS
+//
+uint8_t* TripleBuffer::getWriteBuffer()
+{
+	return pFrames + (frameSize * writeIndex);
+}
+
+// The finished frame becomes the spare, the old spare is ours to write next
+void TripleBuffer::publish()
+{
+	writeIndex = exchange(&middle, writeIndex | TRIPLE_BUFFER_FRESH) & TRIPLE_BUFFER_INDEX;
+}
+
+bool TripleBuffer::update()
+{
+	if(!(load(&middle) & TRIPLE_BUFFER_FRESH)) return false;
+	
+	// Still fresh even if the producer published again since the test, we just get a newer frame
+	readIndex = exchange(&middle, readIndex) & TRIPLE_BUFFER_INDEX;
+	return true;
+}
+
+const uint8_t* TripleBuffer::getReadBuffer()
+{
+	return pFrames + (frameSize * readIndex);
+}
+
+uint16_t TripleBuffer::getFrameSize()
+{
+	return frameSize;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//  PRIVATE FUNCTIONS
+//
+// Byte reads are atomic on AVR, elsewhere the compiler has to be told
+uint8_t TripleBuffer::load(volatile uint8_t* pValue)
+{
+#if defined(__AVR__)
+	return *pValue;
+#else
+	return __atomic_load_n(pValue, __ATOMIC_ACQUIRE);
+#endif
+}
+
+// Swap a value in, returning the old one, as one indivisible step
+uint8_t TripleBuffer::exchange(volatile uint8_t* pValue, uint8_t value)
+{
+#if defined(__AVR__)
+	uint8_t sreg = SREG;
+	cli();
+	uint8_t old = *pValue;
+	*pValue = value;
+	SREG = sreg; // Interrupts back the way they were
+	return old;
+#else
+	return __atomic_exchange_n(pValue, value, __ATOMIC_ACQ_REL);
+#endif
+}
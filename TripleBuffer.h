@@ -0,0 +1,78 @@
+/*
+	MatrixDisplay Library 2.0
+	Author: Miles Burton, www.milesburton.com/
+	Need a 16x24 display? Check out www.mnethardware.co.uk
+	Copyright (c) 2010 Miles Burton All Rights Reserved
+
+	This library is free software; you can redistribute it and/or
+	modify it under the terms of the GNU Lesser General Public
+	License as published by the Free Software Foundation; either
+	version 2.1 of the License, or (at your option) any later version.
+
+	This library is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+	Lesser General Public License for more details.
+
+	You should have received a copy of the GNU Lesser General Public
+	License along with this library; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#ifndef TRIPLE_BUFFER_GUARD
+#define TRIPLE_BUFFER_GUARD
+
+#include <inttypes.h>
+#include <string.h>
+#include <stdlib.h>
+
+/*
+Hands whole frames from one producer (e.g. a serial RX interrupt) to one consumer (loop()) without
+either side waiting for the other.
+
+There are three frames: the producer's, the consumer's and a spare in the middle. publish() swaps
+the producer's finished frame with the spare, update() swaps the spare with the consumer's frame if
+a new one was published since. Each swap is a single exchange of one byte (interrupts off for a few
+cycles on AVR, an atomic exchange elsewhere), so the producer never blocks, a frame is never shown
+half written and the consumer always gets the newest complete one. Frames published faster than
+they're consumed are dropped, never queued.
+
+	ISR:	fill tb.getWriteBuffer(), then tb.publish()
+	loop():	if(tb.update()) disp.syncFrom(tb.getReadBuffer());
+
+Only one producer and one consumer, each side must stick to its own functions.
+*/
+
+class TripleBuffer
+{
+private:
+	uint8_t* pFrames;
+	uint16_t frameSize;
+	
+	uint8_t writeIndex; // Producer's frame
+	uint8_t readIndex; // Consumer's frame
+	volatile uint8_t middle; // Spare frame index, plus TRIPLE_BUFFER_FRESH once published
+	
+	static uint8_t load(volatile uint8_t* pValue);
+	static uint8_t exchange(volatile uint8_t* pValue, uint8_t value);
+	
+public:
+	// Constructor
+	// frameSize - bytes per frame, e.g. 32 * displays for MatrixDisplay::syncFrom()
+	TripleBuffer(uint16_t frameSize);
+	
+	// Destructor
+	~TripleBuffer();
+	
+	// Producer
+	uint8_t* getWriteBuffer();
+	void publish();
+	
+	// Consumer. update() returns true when a newer frame has been taken
+	bool update();
+	const uint8_t* getReadBuffer();
+	
+	uint16_t getFrameSize();
+};
+
+#endif
@@ -0,0 +1,26 @@
+#include "MatrixDisplay.h"
+#include "Animation.h"
+#include "bounce.h"
+
+// Macro to make it the initDisplay function a little easier to understand
+#define setMaster(dispNum, CSPin) initDisplay(dispNum,CSPin,true)
+
+// Init Matrix
+MatrixDisplay disp(1,11,10, false);
+
+// Plays bounce.h straight from flash, rebuild it from bounce.txt with tools/animpack
+Animation anim(&disp);
+
+void setup() {
+  // Prepare displays
+  disp.setMaster(0,4);
+  disp.clear(true);
+
+  anim.play(bounce);
+}
+
+void loop()
+{
+  // The frame delays come from the data, we only push out what changed
+  if(anim.update()) disp.syncDirty();
+}
@@ -0,0 +1,20 @@
+// Generated by tools/animpack from examples/Animated/bounce.txt, 14 frames of 32 columns
+#ifndef ANIMATION_bounce_GUARD
+#define ANIMATION_bounce_GUARD
+
+#include <avr/pgmspace.h>
+
+static const uint8_t bounce[147] PROGMEM = {
+	0x20, 0x00, 0x0E, 0x00, 0x00, 0x00, 0x11, 0x00, 0x3C, 0x00, 0x81, 0x80, 0xC3, 0xE0, 0xDC, 0x80,
+	0x00, 0x3C, 0x00, 0x01, 0x82, 0x80, 0x80, 0xC3, 0x8C, 0x00, 0x3C, 0x00, 0x03, 0x82, 0x80, 0x80,
+	0xC3, 0x83, 0x00, 0x3C, 0x00, 0x05, 0x82, 0x80, 0x80, 0xC3, 0x81, 0x00, 0x3C, 0x00, 0x07, 0x82,
+	0x80, 0x80, 0x01, 0x82, 0x81, 0x81, 0x00, 0x3C, 0x00, 0x09, 0x82, 0x80, 0x80, 0xC3, 0x83, 0x00,
+	0x3C, 0x00, 0x0B, 0x82, 0x80, 0x80, 0xC3, 0x8C, 0x00, 0x3C, 0x00, 0x0D, 0x82, 0x80, 0x80, 0xC3,
+	0xE0, 0x00, 0x3C, 0x00, 0x0F, 0x82, 0x80, 0x80, 0xC3, 0x8C, 0x00, 0x3C, 0x00, 0x11, 0x82, 0x80,
+	0x80, 0xC3, 0x83, 0x00, 0x3C, 0x00, 0x13, 0x82, 0x80, 0x80, 0xC3, 0x81, 0x00, 0x3C, 0x00, 0x15,
+	0x82, 0x80, 0x80, 0x01, 0x82, 0x81, 0x81, 0x00, 0x3C, 0x00, 0x17, 0x82, 0x80, 0x80, 0xC3, 0x83,
+	0x00, 0x3C, 0x00, 0x19, 0x82, 0x80, 0x80, 0xC3, 0x8C, 0x00, 0x3C, 0x00, 0x01, 0xC3, 0xE0, 0x17,
+	0xC5, 0x80, 0x00
+};
+
+#endif
@@ -1,5 +1,7 @@
 #include "MatrixDisplay.h"
 #include "DisplayToolbox.h"
+#include "Marquee.h"
+#include "Transition.h"
 #include "font.h"
 
 #define DEMOTIME 30000  // 30 seconds max on each demo is enough.
@@ -41,8 +43,14 @@ void setup() {
 void loop() {
    demoText(); // Bouncy hello
 
+  demoMarquee(); // Scrolling message
+
   demoBouncyCircle(); 
 
+  demoRotozoom(); // Spinning, zooming logo
+
+  demoTransitions(); // Wipe, slide, dissolve and blinds
+
   demo_bouncyline(); // Bouncy line
   
   demo_life(); // Basic life demo
@@ -136,10 +144,10 @@ void demo_bouncyline ()
   dy1 = random(1,4);
   dy2 = random(1,4);
   for (int i=0; i < DEMOTIME/DISPDELAY; i++) {
-    toolbox.drawLine(x1,y1, x2,y2, 1);
+    toolbox.drawLine(x1,y1, x2,y2, ROP_XOR);
     disp.syncDisplays(); 
     delay(DISPDELAY);
-    toolbox.drawLine(x1,y1, x2,y2, 0);
+    toolbox.drawLine(x1,y1, x2,y2, ROP_XOR); // Drawing it again with XOR puts back whatever was underneath
 
     x1 += dx1;
     if (x1 > X_MAX) {
@@ -216,7 +224,67 @@ void demoText()
 
 
 
+// Scroll a message through the whole chain. Only the string and a cursor are kept,
+// each step shifts the buffer and draws the one new column at the right hand edge
+void demoMarquee()
+{
+  Marquee marquee(&disp, 0, X_MAX, 0);
+  marquee.setFont((const uint8_t*)myfont);
+  marquee.setText("MatrixDisplay marquee, as long as you like");
+  marquee.setLoop(false);
+
+  disp.clear(true);
+  while(marquee.step())
+  {
+    disp.syncDirty();
+    delay(30);
+  }
+}
+
+
 // Small circle bouncing around the bounds
+// An arrow, column packed (bit 0 at the top)
+static const uint8_t PROGMEM arrow[8] = { 0x18, 0x18, 0x18, 0x18, 0x99, 0x5A, 0x3C, 0x18 };
+
+void demoRotozoom()
+{
+  for (int i=0; i < 360; i += 5)
+  {
+    // Zoom in and out once per turn, 1x to 2x
+    uint16_t scale = 256 + (toolbox.sin8(i * 2) + 255) / 2;
+
+    disp.clear();
+    toolbox.drawRotated(X_MAX/2, Y_MAX/2, arrow, 8, 8, i, scale, ROP_COPY, true);
+    disp.syncDisplays();
+    delay(20);
+  }
+}
+
+void demoTransitions()
+{
+  // Draw a picture and keep it in the shadow buffer as the target
+  disp.clear();
+  toolbox.drawRectangle(1, 0, X_MAX - 3, Y_MAX - 1, ROP_SET);
+  toolbox.fillCircle(X_MAX/2, Y_MAX/2, 2);
+  disp.copyBuffer();
+
+  Transition transition(&disp);
+  for (uint8_t effect = TRANSITION_WIPE; effect <= TRANSITION_BLINDS; effect++)
+  {
+    disp.clear(true);
+
+    // Only the columns each step changes are sent
+    transition.start(effect, disp.getBuffer(0, true));
+    while (transition.step())
+    {
+      disp.syncDirty();
+      delay(40);
+    }
+    disp.syncDirty();
+    delay(LONGDELAY);
+  }
+}
+
 void demoBouncyCircle()
 {
   int radius = 3; 
@@ -0,0 +1,72 @@
+#include "MatrixDisplay.h"
+#include "DisplayToolbox.h"
+#include "FrameScheduler.h"
+
+// Macro to make it the initDisplay function a little easier to understand
+#define setMaster(dispNum, CSPin) initDisplay(dispNum,CSPin,true)
+#define setSlave(dispNum, CSPin) initDisplay(dispNum,CSPin,false)
+
+// Init Matrix
+MatrixDisplay disp(1,11,10, false);
+// Pass a copy of the display into the toolbox
+DisplayToolbox toolbox(&disp);
+
+void update();
+void render();
+void idle();
+
+// Run update/render 25 times a second, idle() gets whatever time is left over
+FrameScheduler scheduler(25, update, render, idle);
+
+// Prepare boundaries
+uint8_t X_MAX = 0;
+uint8_t Y_MAX = 0;
+
+int x = 0;
+int dx = 1;
+
+void setup() {
+  Serial.begin(9600);
+
+  // Fetch bounds
+  X_MAX = disp.getDisplayCount() * (disp.getDisplayWidth()-1)+1;
+  Y_MAX = disp.getDisplayHeight();
+
+  // Prepare displays
+  disp.setMaster(0,4);
+}
+
+void loop()
+{
+  // No delay() here, the scheduler decides when each frame is due
+  scheduler.tick();
+}
+
+// Move things along one timestep
+void update()
+{
+  toolbox.drawLine(x, 0, x, Y_MAX-1, 0); // Erase the old bar
+
+  x += dx;
+  if(x <= 0 || x >= X_MAX-1) dx = -dx;
+
+  toolbox.drawLine(x, 0, x, Y_MAX-1, 1);
+}
+
+// Push the changes out
+void render()
+{
+  disp.syncDirty(); // Only the two columns which changed
+}
+
+// Spare time between frames
+void idle()
+{
+  if(Serial.available() && Serial.read() == '?')
+  {
+    Serial.print("overruns ");
+    Serial.println((int)scheduler.getOverruns());
+    Serial.print("max jitter us ");
+    Serial.println((int)scheduler.getMaxJitter());
+  }
+}
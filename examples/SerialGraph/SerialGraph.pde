@@ -1,5 +1,6 @@
 #include "MatrixDisplay.h"
 #include "DisplayToolbox.h"
+#include "TaskRunner.h"
 
 // Easy to use function
 #define setMaster(dispNum, CSPin) initDisplay(dispNum,CSPin,true)
@@ -15,6 +16,11 @@ MatrixDisplay disp(4,11,10, false);
 // Pass a copy of the display into the toolbox
 DisplayToolbox toolbox(&disp);
 
+// Serial parsing and the display sync share loop() as cooperative tasks, neither can stall the other
+TaskRunner tasks;
+bool serialTask(TaskRunner* runner);
+bool syncTask(TaskRunner* runner);
+
 // Prepare boundaries
 uint8_t X_MAX = 0;
 uint8_t Y_MAX = 0;
@@ -31,10 +37,13 @@ void setup() {
   digitalWrite(13, LOW);
 
   // Prepare displays
-  disp.setMaster(0,4);
-  disp.setSlave(1,5);
-  disp.setSlave(2,6);
-  disp.setSlave(3,7);
+  // Same as setMaster(0,4), setSlave(1,5)... but the slaves are set up together in one go
+  const uint8_t pins[] = {4, 5, 6, 7};
+  disp.initDisplays(pins, 0);
+
+  // Budgets in microseconds per pass of loop()
+  tasks.addTask(serialTask, 500);
+  tasks.addTask(syncTask, 2000);
 }
 
 // Response codes
@@ -52,8 +61,14 @@ void setup() {
 #define CMD_GETWIDTH 6
 #define CMD_GETHEIGHT 7
 
-// An error flag
-bool dataError = false;
+// Give up on a half received command after this long
+#define DATA_TIMEOUT_MS 50
+
+// Parser state, kept between passes so a command can arrive a byte at a time
+byte cmd = 0;
+byte args[4];
+byte argCount = 0;
+unsigned long lastByte = 0;
 
 
 // Blinken lights! Good for diagnostics
@@ -67,116 +82,101 @@ void blink()
 
 void loop ()
 {
-  // Check we've got data
-  if(Serial.available())
-  {
-    // First peice should be the command
-    byte cmd = Serial.read();      
-
-    // What does the host want us to do?
-    switch(cmd)
-    {
-    case CMD_HELLO:
-      Serial.write(RSP_CONF); // Return Understood
-      blink();
-      break;
-    case CMD_DRAWLINE:
-      {
-        int uBound = Y_MAX-getData(0)-1; // Get line top (aka 16)
-        int lBound = Y_MAX-getData(0); // Get line low (aka 0)
-        int yHeight = Y_MAX-getData(0); // Get line height (aka 5)
-        int x = getData(0); // Get line height (aka 24)
-
-        if(dataError)
-        { 
-          dataError = false;
-          return;
-        }
-
-        // Draw each pixel from the bottom of the display to the top
-        // Light up a pixel when yHeight is hit
-        int val = 0;
-        // Hard coded to 15 and 0 while debugging (should be y=uBound; y>lBound
-        for(int y=15; y>0; y--)
-        {
-
-          // Check which pixel to light
-          if(yHeight < y){ 
-            val = 1;
-          }
-          else{
-            val =0; 
-          }
-          
-          // Set a pixel in the back buffer
-          toolbox.setPixel(x, y, val);
-        }
-
-       // Render our changes (don't bother rending if we're at X_MAX as we're only going to shift anyway
-       if(x+1<X_MAX) disp.syncDisplays();
-
-        Serial.write(RSP_CONF); // Return Understood
-      }
-      break;
-    case  CMD_SHIFTLEFT:
-      {
-        disp.shiftLeft();
-        disp.syncDisplays(); // Render our changes
-        Serial.write(RSP_CONF);  // Return Understood
-      }
-      break;
-    case  CMD_CLEAR:
-      {
-        disp.clear(); // Nuke the display
-        Serial.write(RSP_CONF); // Return understood
-        disp.syncDisplays(); 
-      }
-    case CMD_GETWIDTH:
-      {
-        // How wide is our display?
-        Serial.write(X_MAX);
-      }
-    case CMD_GETHEIGHT:
-      {
-        // How high is our display
-        Serial.write(Y_MAX); 
-      }
-    default:
-      
-      // Say sorry we dont understand
-      Serial.write(RSP_UNK);
-    }
-
-
-
-
-  }
+  // Never blocks, each task does a slice of work and comes back
+  tasks.run();
 }
 
+// How many argument bytes follow a command
+byte argumentsFor(byte command)
+{
+  return command == CMD_DRAWLINE ? 4 : 0;
+}
 
-// Fetch data with delay
-byte getData(int timeout)
+// A complete command is in, act on it. The drawing only touches the back buffer, syncTask sends it
+void execute()
 {
-  for(int i=0;i<(timeout<=0) ? 50 : timeout; i++)
+  // What does the host want us to do?
+  switch(cmd)
   {
-    while(!Serial.available())
-    { 
-      delay(1); 
-    } // Wait for data 
+  case CMD_HELLO:
+    Serial.write(RSP_CONF); // Return Understood
+    blink();
+    break;
+  case CMD_DRAWLINE:
+    {
+      int yHeight = Y_MAX-args[2]; // Get line height (aka 5)
+      int x = args[3]; // Get line height (aka 24)
 
-    if(!Serial.available()) dataError = true;
+      // Draw each pixel from the bottom of the display to the top
+      // Light up a pixel when yHeight is hit
+      // Hard coded to 15 and 0 while debugging (should be y=uBound; y>lBound
+      for(int y=15; y>0; y--)
+      {
+        // Set a pixel in the back buffer
+        toolbox.setPixel(x, y, yHeight < y ? 1 : 0);
+      }
 
-    return Serial.read();
+      Serial.write(RSP_CONF); // Return Understood
+    }
+    break;
+  case  CMD_SHIFTLEFT:
+    disp.shiftLeft();
+    Serial.write(RSP_CONF);  // Return Understood
+    break;
+  case  CMD_CLEAR:
+    disp.clear(); // Nuke the display
+    Serial.write(RSP_CONF); // Return understood
+    break;
+  case CMD_GETWIDTH:
+    // How wide is our display?
+    Serial.write(X_MAX);
+    break;
+  case CMD_GETHEIGHT:
+    // How high is our display
+    Serial.write(Y_MAX); 
+    break;
+  default:
+    // Say sorry we dont understand
+    Serial.write(RSP_UNK);
   }
 }
 
+// Consume whatever bytes have arrived, one at a time, until the budget runs out
+bool serialTask(TaskRunner* runner)
+{
+  // Drop a command whose arguments stopped coming
+  if(cmd && millis() - lastByte > DATA_TIMEOUT_MS) cmd = 0;
 
+  while(Serial.available() && runner->timeLeft())
+  {
+    byte b = Serial.read();
+    lastByte = millis();
 
+    if(!cmd)
+    {
+      // First peice should be the command
+      cmd = b;
+      argCount = 0;
+    }
+    else
+    {
+      args[argCount++] = b;
+    }
 
+    if(argCount == argumentsFor(cmd))
+    {
+      execute();
+      cmd = 0;
+    }
+  }
 
+  return Serial.available() > 0;
+}
 
-
-
-
-
-
+// Send the changed columns a run at a time
+bool syncTask(TaskRunner* runner)
+{
+  bool more = true;
+  while(more && runner->timeLeft()) more = disp.syncDirtyStep();
+  return more;
+}
@@ -83,6 +83,22 @@ void loop()
 	
 	delay(2000); // Wait two seconds
 	
+	// Writing pixels straight to the display sends a whole command for every pixel. Turn on write combining
+	// and neighbouring pixels are queued up and sent together, up to 64 nybbles (a whole display) at a time.
+	disp.clear(true);
+	disp.setWriteCombining(64);
+	for(int y=0; y < Y_MAX; ++y)
+	{
+		for(int x = 0; x< X_MAX; ++x)
+		{
+			toolbox.setPixel(x, y, 1, true);
+		}
+	}
+	disp.flushWrites(); // Send whatever is still queued
+	disp.setWriteCombining(0);
+	
+	delay(2000); // Wait two seconds
+	
 	// Okay lets clear the buffer
 	disp.clear();
 	// ...and write the result to the displays
@@ -111,6 +127,15 @@ void loop()
 		 delay(200); // Let's wait a bit or you'll miss it!
 	}
 	
+	// The toolbox can also fade for you without blocking. Levels are perceived brightness (0-255)
+	// and all the displays in the group are changed with one command.
+	toolbox.fadeBrightness(ALL_PANELS, 255, 0, 2000);
+	while(toolbox.updateFades())
+	{
+		// Free to do other work here, updateFades() returns straight away
+	}
+	toolbox.setBrightness(15);
+	
 	
 	
 	// Okay lets clear the buffer
@@ -1,6 +1,17 @@
+#ifndef FONT_GUARD
+#define FONT_GUARD
+
 #include <avr/pgmspace.h>
+
+// constexpr lets StaticLabel.h rasterize with the glyphs at compile time (C++11 and later)
+#if __cplusplus >= 201103L
+#define FONT_STORAGE constexpr
+#else
+#define FONT_STORAGE const
+#endif
+
 const int font_count = 127;
-unsigned char PROGMEM myfont[127][5] = {
+FONT_STORAGE unsigned char PROGMEM myfont[127][5] = {
   {0x00, 0x00, 0x00, 0x00, 0x00}, // blank
   {0x00, 0x00, 0x00, 0x00, 0x00}, // blank
   {0x00, 0x00, 0x00, 0x00, 0x00}, // blank
@@ -128,3 +139,5 @@ unsigned char PROGMEM myfont[127][5] = {
   {0x00, 0x00, 0xFF, 0x00, 0x00}, // |
   {0x00, 0x81, 0x66, 0x18, 0x18}, // }
   {0x4, 0x8, 0xC, 0x4, 0x8}};     // ~
+
+#endif
@@ -0,0 +1,168 @@
+/*
+	MatrixDisplay Library 2.0 - Animation playback check
+	Author: Miles Burton, www.milesburton.com/
+	Copyright (c) 2010 Miles Burton All Rights Reserved
+
+	This library is free software; you can redistribute it and/or
+	modify it under the terms of the GNU Lesser General Public
+	License as published by the Free Software Foundation; either
+	version 2.1 of the License, or (at your option) any later version.
+
+	This library is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+	Lesser General Public License for more details.
+
+	You should have received a copy of the GNU Lesser General Public
+	License along with this library; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+/*
+Plays a packed animation through the library on the host simulator (tools/hostsim) and checks what
+the panels show against animpack's source frames. Every frame is decoded by Animation::update(now)
+and sent with syncDirty(), then the simulated panel RAM has to match the source frame, on time, for
+three trips round the loop.
+
+Build:   g++ -std=c++11 -I../hostsim -I../.. -o animcheck animcheck.cpp ../../Animation.cpp ../../MatrixDisplay.cpp ../hostsim/hostsim.cpp
+Usage:   animcheck [frames.txt, default ../../examples/Animated/bounce.txt]
+
+The packed data is compiled in, bounce.h by default. For another animation build with
+	-DANIM_HEADER='"myanim.h"' -DANIM_DATA=myanim
+and pass the frames file it was packed from.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include <fstream>
+#include "MatrixDisplay.h"
+#include "Animation.h"
+#include "hostsim.h"
+
+#ifndef ANIM_HEADER
+#define ANIM_HEADER "../../examples/Animated/bounce.h"
+#define ANIM_DATA   bounce
+#endif
+#include ANIM_HEADER
+
+#define PANEL_WIDTH 32
+#define LOOP_TRIPS  3
+
+struct Frame
+{
+	int delay;
+	std::vector<uint8_t> columns;
+};
+
+static void fail(const char* msg)
+{
+	fprintf(stderr, "animcheck: %s\n", msg);
+	exit(1);
+}
+
+// The same text format animpack reads
+static void loadFrames(const char* path, std::vector<Frame>& frames, int& loopFrame)
+{
+	std::ifstream in(path);
+	if(!in) fail("can't open the frames file");
+	
+	loopFrame = -1;
+	int row = 0;
+	std::string line;
+	while(std::getline(in, line))
+	{
+		if(!line.empty() && line[line.size() - 1] == '\r') line.erase(line.size() - 1);
+		if(line.empty() || line[0] == ';') continue;
+		
+		if(line == "loop") loopFrame = (int)frames.size();
+		else if(line.compare(0, 6, "frame ") == 0)
+		{
+			Frame frame;
+			frame.delay = atoi(line.c_str() + 6);
+			frames.push_back(frame);
+			row = 0;
+		}
+		else
+		{
+			if(frames.empty() || row > 7) fail("rows outside a frame");
+			std::vector<uint8_t>& columns = frames.back().columns;
+			if(columns.size() < line.size()) columns.resize(line.size(), 0);
+			for(size_t x = 0; x < line.size(); ++x) if(line[x] == '#') columns[x] |= 1 << row;
+			++row;
+		}
+	}
+}
+
+int main(int argc, char** argv)
+{
+	const char* path = argc > 1 ? argv[1] : "../../examples/Animated/bounce.txt";
+	std::vector<Frame> frames;
+	int loopFrame;
+	loadFrames(path, frames, loopFrame);
+	if(frames.empty()) fail("no frames");
+	
+	uint16_t columns = pgm_read_word(ANIM_DATA);
+	int displays = (columns + PANEL_WIDTH - 1) / PANEL_WIDTH;
+	if(displays > 8) fail("more than 8 panels");
+	for(size_t f = 0; f < frames.size(); ++f) frames[f].columns.resize(displays * PANEL_WIDTH, 0);
+	
+	const uint8_t csPins[] = { 2, 3, 4, 5, 6, 7, 8, 9 };
+	MatrixDisplay disp(displays, 11, 10);
+	disp.initDisplays(csPins, 0);
+	hostsimClearPanels();
+	hostsimWatchBus(11, 10);
+	
+	Animation anim(&disp);
+	anim.play(ANIM_DATA);
+	
+	// Walk the clock a millisecond at a time, each frame is due when the last one's delay is up
+	int expected = 0;
+	unsigned long due = 0;
+	int shown = 0;
+	int trips = 0;
+	int mismatches = 0;
+	int lateOrEarly = 0;
+	
+	for(unsigned long now = 0; trips < LOOP_TRIPS && anim.isPlaying(); ++now)
+	{
+		bool decoded = anim.update(now);
+		if(decoded != (now == due)) ++lateOrEarly;
+		if(!decoded) continue;
+		
+		disp.syncDirty();
+		if(anim.getFrame() != expected) ++lateOrEarly;
+		
+		const Frame& frame = frames[expected];
+		for(int d = 0; d < displays; ++d)
+		{
+			const uint8_t* ram = hostsimPanelRam(csPins[d]);
+			for(int x = 0; x < PANEL_WIDTH; ++x)
+			{
+				uint8_t column = ram[x * 2] | (ram[x * 2 + 1] << 4);
+				if(column != frame.columns[d * PANEL_WIDTH + x])
+				{
+					if(mismatches < 8) printf("  frame %d, display %d, column %d: panel shows 0x%02X, frame has 0x%02X\n",
+						expected, d, x, column, frame.columns[d * PANEL_WIDTH + x]);
+					++mismatches;
+				}
+			}
+		}
+		++shown;
+		
+		due = now + frame.delay;
+		if(++expected == (int)frames.size())
+		{
+			if(loopFrame < 0) break;
+			expected = loopFrame;
+			++trips;
+		}
+	}
+	
+	printf("%d frames shown, %d trips round the loop: %d columns differ, %d frames off time\n", shown, trips, mismatches, lateOrEarly);
+	bool passed = mismatches == 0 && lateOrEarly == 0 && (loopFrame < 0 || trips == LOOP_TRIPS);
+	printf("%s\n", passed ? "passed" : "FAILED");
+	return passed ? 0 : 1;
+}
@@ -0,0 +1,330 @@
+/*
+	MatrixDisplay Library 2.0 - Animation packer
+	Author: Miles Burton, www.milesburton.com/
+	Copyright (c) 2010 Miles Burton All Rights Reserved
+
+	This library is free software; you can redistribute it and/or
+	modify it under the terms of the GNU Lesser General Public
+	License as published by the Free Software Foundation; either
+	version 2.1 of the License, or (at your option) any later version.
+
+	This library is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+	Lesser General Public License for more details.
+
+	You should have received a copy of the GNU Lesser General Public
+	License along with this library; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+/*
+Host tool, packs a sequence of frames into the compressed stream played by Animation (see Animation.h).
+
+Build:   g++ -O2 -std=c++11 -o animpack animpack.cpp
+Usage:   animpack [options] frames.txt > myanim.h
+	-n name      C name for the data (default: anim)
+	-c columns   Width of the animation in columns (default: widest frame)
+	-p           Print every frame of the playback to stderr
+
+Input is plain text, one frame after another:
+	; comment
+	frame 100    starts a frame shown for 100ms, followed by up to 8 rows of pixels ('#' is lit)
+	loop         playback returns to the next frame after the last one (default: play once)
+
+Each frame is stored as a delta against the one before it. After packing the stream is decoded
+again the way the player does it, including the trip round the loop, and compared with the input
+frames. Any mismatch is an error. That's a quick check of the packer only, animcheck.cpp plays the
+packed data through the library itself on the host simulator.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <string>
+#include <vector>
+#include <fstream>
+#include <sstream>
+
+// Must match Animation.h
+#define ANIM_NO_LOOP     0xFFFF
+#define ANIM_HEADER_SIZE 8
+#define ANIM_OP_END      0x00
+#define ANIM_OP_LITERAL  0x80
+#define ANIM_OP_REPEAT   0xC0
+#define ANIM_RUN_MASK    0x3F
+#define ANIM_MAX_SKIP    0x7F
+
+// Repeats at least this long are cheaper than literals
+#define MIN_REPEAT 3
+
+struct Frame
+{
+	int delay;
+	std::vector<uint8_t> columns; // bit 0 = top row
+};
+
+static void fail(const char* msg)
+{
+	fprintf(stderr, "animpack: %s\n", msg);
+	exit(1);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//  INPUT
+//
+static void load(std::istream& in, std::vector<Frame>& frames, int& loopFrame)
+{
+	std::string line;
+	int row = 0;
+	int lineNum = 0;
+	loopFrame = ANIM_NO_LOOP;
+
+	while(std::getline(in, line))
+	{
+		++lineNum;
+		if(!line.empty() && line[line.size() - 1] == '\r') line.erase(line.size() - 1);
+		if(line.empty() || line[0] == ';') continue;
+
+		std::istringstream words(line);
+		std::string word;
+		words >> word;
+		if(word == "frame")
+		{
+			Frame f;
+			f.delay = 0;
+			if(!(words >> f.delay) || f.delay < 0 || f.delay > 0xFFFF) fail("frame needs a delay of 0-65535ms");
+			frames.push_back(f);
+			row = 0;
+		}
+		else if(word == "loop")
+		{
+			loopFrame = (int)frames.size();
+		}
+		else if(!frames.empty() && line.find_first_not_of(".#") == std::string::npos)
+		{
+			if(row >= 8) { fprintf(stderr, "line %d: ", lineNum); fail("more than 8 rows in a frame"); }
+			std::vector<uint8_t>& columns = frames.back().columns;
+			if(columns.size() < line.size()) columns.resize(line.size(), 0);
+			for(size_t x = 0; x < line.size(); ++x) if(line[x] == '#') columns[x] |= 1 << row;
+			++row;
+		}
+		else
+		{
+			fprintf(stderr, "line %d: ", lineNum);
+			fail("expected frame, loop or a row of . and #");
+		}
+	}
+
+	if(frames.empty()) fail("no frames");
+	if(loopFrame != ANIM_NO_LOOP && loopFrame >= (int)frames.size()) fail("loop must come before a frame");
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//  ENCODER
+//
+static void put16(std::vector<uint8_t>& out, unsigned value)
+{
+	out.push_back(value & 0xFF);
+	out.push_back(value >> 8);
+}
+
+static size_t repeatLength(const std::vector<uint8_t>& cur, size_t x)
+{
+	size_t n = 1;
+	while(x + n < cur.size() && n < ANIM_RUN_MASK && cur[x + n] == cur[x]) ++n;
+	return n;
+}
+
+// Ops turning prev into cur
+static void encodeFrame(const std::vector<uint8_t>& prev, const std::vector<uint8_t>& cur, int delay, std::vector<uint8_t>& out)
+{
+	put16(out, delay);
+
+	size_t x = 0;
+	size_t skip = 0;
+	while(x < cur.size())
+	{
+		if(cur[x] == prev[x]) { ++skip; ++x; continue; }
+
+		for(; skip > 0; skip -= skip > ANIM_MAX_SKIP ? ANIM_MAX_SKIP : skip)
+			out.push_back(skip > ANIM_MAX_SKIP ? ANIM_MAX_SKIP : skip);
+
+		size_t repeat = repeatLength(cur, x);
+		if(repeat >= MIN_REPEAT)
+		{
+			out.push_back(ANIM_OP_REPEAT | repeat);
+			out.push_back(cur[x]);
+			x += repeat;
+			continue;
+		}
+
+		// Literal run, a single unchanged column is cheaper to carry along than a skip and a new op
+		size_t start = x;
+		while(x < cur.size() && x - start < ANIM_RUN_MASK)
+		{
+			bool unchanged = cur[x] == prev[x] && (x + 1 >= cur.size() || cur[x + 1] == prev[x + 1]);
+			if(unchanged || (x > start && repeatLength(cur, x) >= MIN_REPEAT)) break;
+			++x;
+		}
+		out.push_back(ANIM_OP_LITERAL | (x - start));
+		out.insert(out.end(), cur.begin() + start, cur.begin() + x);
+	}
+
+	out.push_back(ANIM_OP_END);
+}
+
+static std::vector<uint8_t> pack(const std::vector<Frame>& frames, size_t columns, int loopFrame)
+{
+	std::vector<uint8_t> out;
+	put16(out, columns);
+	put16(out, frames.size());
+	put16(out, loopFrame);
+	put16(out, 0); // Loop offset, patched below
+
+	std::vector<uint8_t> blank(columns, 0);
+	size_t loopOffset = 0;
+	for(size_t i = 0; i < frames.size(); ++i)
+	{
+		if(loopFrame != ANIM_NO_LOOP && i == (size_t)loopFrame + 1) loopOffset = out.size();
+		encodeFrame(i ? frames[i - 1].columns : blank, frames[i].columns, frames[i].delay, out);
+	}
+
+	if(loopFrame != ANIM_NO_LOOP)
+	{
+		// The way back round, loopFrame against the last frame
+		if(loopFrame + 1 == (int)frames.size()) loopOffset = out.size();
+		encodeFrame(frames.back().columns, frames[loopFrame].columns, frames[loopFrame].delay, out);
+		out[6] = loopOffset & 0xFF;
+		out[7] = loopOffset >> 8;
+	}
+
+	if(out.size() > 0xFFFF) fail("animation is over 64K");
+	return out;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//  VERIFY
+//
+// Decode the stream the way Animation does, one frame at a time
+static size_t decodeFrame(const std::vector<uint8_t>& data, size_t pos, std::vector<uint8_t>& buffer, int& delay)
+{
+	delay = data[pos] | (data[pos + 1] << 8);
+	pos += 2;
+
+	size_t x = 0;
+	for(;;)
+	{
+		if(pos >= data.size()) fail("verify: ran off the end of the stream");
+		uint8_t op = data[pos++];
+		if(op == ANIM_OP_END) break;
+		if(!(op & ANIM_OP_LITERAL)) { x += op; continue; }
+
+		uint8_t count = op & ANIM_RUN_MASK;
+		if((op & ANIM_OP_REPEAT) == ANIM_OP_REPEAT)
+		{
+			uint8_t value = data[pos++];
+			while(count--) if(x < buffer.size()) buffer[x++] = value;
+		}
+		else
+		{
+			while(count--) { uint8_t value = data[pos++]; if(x < buffer.size()) buffer[x++] = value; }
+		}
+	}
+	return pos;
+}
+
+static void printFrame(const std::vector<uint8_t>& buffer, int frame, int delay)
+{
+	fprintf(stderr, "frame %d (%dms)\n", frame, delay);
+	for(int y = 0; y < 8; ++y)
+	{
+		for(size_t x = 0; x < buffer.size(); ++x) fputc((buffer[x] >> y) & 1 ? '#' : '.', stderr);
+		fputc('\n', stderr);
+	}
+}
+
+static void verify(const std::vector<uint8_t>& data, const std::vector<Frame>& frames, int loopFrame, bool print)
+{
+	size_t columns = data[0] | (data[1] << 8);
+	size_t loopOffset = data[6] | (data[7] << 8);
+	std::vector<uint8_t> buffer(columns, 0);
+
+	// Once through, then round the loop twice to catch a bad loop frame or offset
+	size_t pos = ANIM_HEADER_SIZE;
+	size_t total = frames.size();
+	if(loopFrame != ANIM_NO_LOOP) total += 2 * (frames.size() - loopFrame);
+
+	int frame = 0;
+	for(size_t shown = 0; shown < total; ++shown)
+	{
+		int delay;
+		pos = decodeFrame(data, pos, buffer, delay);
+
+		if(frame == (int)frames.size())
+		{
+			frame = loopFrame;
+			pos = loopOffset;
+		}
+
+		if(print) printFrame(buffer, frame, delay);
+		if(buffer != frames[frame].columns || delay != frames[frame].delay)
+		{
+			fprintf(stderr, "frame %d: ", frame);
+			fail("verify: playback doesn't match the input");
+		}
+		++frame;
+	}
+}
+
+int main(int argc, char** argv)
+{
+	std::string name = "anim";
+	size_t columns = 0;
+	bool print = false;
+	const char* path = NULL;
+
+	for(int i = 1; i < argc; ++i)
+	{
+		std::string a = argv[i];
+		bool hasValue = i + 1 < argc;
+		if(a == "-n" && hasValue) name = argv[++i];
+		else if(a == "-c" && hasValue) columns = atoi(argv[++i]);
+		else if(a == "-p") print = true;
+		else if(a[0] != '-') path = argv[i];
+		else fail("unknown option, see the top of animpack.cpp for usage");
+	}
+	if(!path) fail("usage: animpack [-n name] [-c columns] [-p] frames.txt");
+
+	std::ifstream in(path);
+	if(!in) fail("can't open the frames");
+
+	std::vector<Frame> frames;
+	int loopFrame;
+	load(in, frames, loopFrame);
+
+	if(columns == 0) for(size_t i = 0; i < frames.size(); ++i) if(frames[i].columns.size() > columns) columns = frames[i].columns.size();
+	if(columns == 0 || columns > 0xFFFF) fail("bad column count");
+	for(size_t i = 0; i < frames.size(); ++i)
+	{
+		if(frames[i].columns.size() > columns) fail("a frame is wider than the column count");
+		frames[i].columns.resize(columns, 0);
+	}
+
+	std::vector<uint8_t> data = pack(frames, columns, loopFrame);
+	verify(data, frames, loopFrame, print);
+
+	printf("// Generated by tools/animpack from %s, %u frames of %u columns\n", path, (unsigned)frames.size(), (unsigned)columns);
+	printf("#ifndef ANIMATION_%s_GUARD\n#define ANIMATION_%s_GUARD\n\n", name.c_str(), name.c_str());
+	printf("#include <avr/pgmspace.h>\n\n");
+	printf("static const uint8_t %s[%u] PROGMEM = {", name.c_str(), (unsigned)data.size());
+	for(size_t i = 0; i < data.size(); ++i) printf("%s0x%02X", (i % 16) ? ", " : (i ? ",\n\t" : "\n\t"), data[i]);
+	printf("\n};\n\n#endif\n");
+
+	size_t raw = frames.size() * columns;
+	fprintf(stderr, "%s: %u frames, %u columns, loop %s\n", name.c_str(), (unsigned)frames.size(), (unsigned)columns,
+		loopFrame == ANIM_NO_LOOP ? "off" : std::to_string(loopFrame).c_str());
+	fprintf(stderr, "flash: %u bytes, raw frames would be %u, playback verified\n", (unsigned)data.size(), (unsigned)raw);
+	return 0;
+}
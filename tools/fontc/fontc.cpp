@@ -0,0 +1,327 @@
+/*
+	MatrixDisplay Library 2.0 - Font compiler
+	Author: Miles Burton, www.milesburton.com/
+	Copyright (c) 2010 Miles Burton All Rights Reserved
+
+	This library is free software; you can redistribute it and/or
+	modify it under the terms of the GNU Lesser General Public
+	License as published by the Free Software Foundation; either
+	version 2.1 of the License, or (at your option) any later version.
+
+	This library is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+	Lesser General Public License for more details.
+
+	You should have received a copy of the GNU Lesser General Public
+	License along with this library; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+/*
+Host tool, converts a BDF or PSF (v1/v2) font into a PackedFont header (see PackedFont.h).
+
+Build:   g++ -O2 -std=c++11 -o fontc fontc.cpp
+Usage:   fontc [options] font.bdf|font.psf > myfont.h
+	-n name      C name for the font (default: font)
+	-f first     First character to keep (default: 32)
+	-l last      Last character to keep (default: 126)
+	-s spacing   Blank columns between glyphs (default: 1)
+	-m           Monospace, keep every glyph at the cell width
+	-p text      Render text to stderr the way DisplayToolbox::drawString would show it
+
+Glyphs are trimmed to the columns they use (unless -m), rows are packed with bit 0 at the
+top to match the display buffer. Fonts taller than 8 rows are rejected, that's one panel.
+A summary of the flash used is printed to stderr.
+
+fontcheck.cpp draws a generated font with the library on the host simulator and checks it
+against the packed columns and the -p preview.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <string>
+#include <vector>
+#include <fstream>
+#include <sstream>
+
+struct Glyph
+{
+	bool present;
+	std::vector<uint8_t> columns; // bit 0 = top row
+	Glyph() : present(false) {}
+};
+
+struct Font
+{
+	int width; // Cell size
+	int height;
+	std::vector<Glyph> glyphs; // Indexed by character code
+};
+
+static void fail(const char* msg)
+{
+	fprintf(stderr, "fontc: %s\n", msg);
+	exit(1);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//  BDF
+//
+static bool loadBdf(const std::vector<uint8_t>& data, Font& font)
+{
+	std::string text(data.begin(), data.end());
+	std::istringstream in(text);
+	std::string line;
+
+	int boxW = 0, boxH = 0, boxX = 0, boxY = 0;
+	int ascent = -1;
+	bool sawHeader = false;
+
+	int encoding = -1;
+	int gw = 0, gh = 0, gx = 0, gy = 0;
+	bool inBitmap = false;
+	int row = 0;
+
+	while(std::getline(in, line))
+	{
+		std::istringstream ls(line);
+		std::string key;
+		ls >> key;
+
+		if(key == "STARTFONT") sawHeader = true;
+		else if(key == "FONTBOUNDINGBOX") ls >> boxW >> boxH >> boxX >> boxY;
+		else if(key == "FONT_ASCENT") ls >> ascent;
+		else if(key == "STARTCHAR") { encoding = -1; gw = gh = gx = gy = 0; }
+		else if(key == "ENCODING") ls >> encoding;
+		else if(key == "BBX") ls >> gw >> gh >> gx >> gy;
+		else if(key == "BITMAP")
+		{
+			if(!sawHeader || boxH == 0) fail("BDF without a FONTBOUNDINGBOX");
+			if(ascent < 0) ascent = boxH + boxY;
+			font.width = boxW;
+			font.height = boxH;
+			if(encoding >= 0 && encoding < 256)
+			{
+				Glyph& g = font.glyphs[encoding];
+				g.present = true;
+				g.columns.assign(boxW, 0);
+			}
+			inBitmap = true;
+			row = 0;
+		}
+		else if(key == "ENDCHAR") inBitmap = false;
+		else if(inBitmap)
+		{
+			if(encoding < 0 || encoding >= 256) continue;
+
+			// Place the glyph row inside the font cell
+			int cellRow = ascent - (gy + gh) + row;
+			int cellCol = gx - boxX;
+			unsigned long bits = strtoul(key.c_str(), NULL, 16);
+			int bitCount = (int)key.size() * 4;
+
+			Glyph& g = font.glyphs[encoding];
+			for(int c = 0; c < gw; ++c)
+			{
+				if(!((bits >> (bitCount - 1 - c)) & 1)) continue;
+				int x = cellCol + c;
+				if(x < 0 || x >= boxW || cellRow < 0 || cellRow >= boxH) continue;
+				g.columns[x] |= 1 << cellRow;
+			}
+			++row;
+		}
+	}
+	return sawHeader;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//  PSF
+//
+static void psfGlyph(Font& font, int code, const uint8_t* p, int width, int height)
+{
+	int rowBytes = (width + 7) / 8;
+	Glyph& g = font.glyphs[code];
+	g.present = true;
+	g.columns.assign(width, 0);
+	for(int y = 0; y < height; ++y)
+	{
+		for(int x = 0; x < width; ++x)
+		{
+			if(p[y * rowBytes + x / 8] & (0x80 >> (x & 7))) g.columns[x] |= 1 << y;
+		}
+	}
+}
+
+static uint32_t le32(const uint8_t* p)
+{
+	return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static bool loadPsf(const std::vector<uint8_t>& data, Font& font)
+{
+	if(data.size() >= 4 && data[0] == 0x36 && data[1] == 0x04)
+	{
+		// PSF1, always 8 wide
+		int height = data[3];
+		int count = (data[2] & 1) ? 512 : 256;
+		font.width = 8;
+		font.height = height;
+		if(data.size() < 4 + (size_t)count * height) fail("truncated PSF1 file");
+		for(int i = 0; i < 256; ++i) psfGlyph(font, i, &data[4 + i * height], 8, height);
+		return true;
+	}
+
+	if(data.size() >= 32 && le32(&data[0]) == 0x864ab572)
+	{
+		uint32_t headerSize = le32(&data[8]);
+		uint32_t count = le32(&data[16]);
+		uint32_t glyphSize = le32(&data[20]);
+		font.height = le32(&data[24]);
+		font.width = le32(&data[28]);
+		if(data.size() < headerSize + (size_t)count * glyphSize) fail("truncated PSF2 file");
+		for(uint32_t i = 0; i < count && i < 256; ++i) psfGlyph(font, i, &data[headerSize + i * glyphSize], font.width, font.height);
+		return true;
+	}
+	return false;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//  OUTPUT
+//
+struct Packed
+{
+	int first, last;
+	std::vector<uint8_t> widths;
+	std::vector<uint16_t> offsets;
+	std::vector<uint8_t> columns;
+};
+
+static Packed pack(const Font& font, int first, int last, bool monospace)
+{
+	Packed p;
+	p.first = first;
+	p.last = last;
+	for(int c = first; c <= last; ++c)
+	{
+		const Glyph& g = font.glyphs[c];
+		int start = 0, end = g.present ? (int)g.columns.size() : 0;
+
+		if(!monospace)
+		{
+			while(start < end && g.columns[start] == 0) ++start;
+			while(end > start && g.columns[end - 1] == 0) --end;
+			// Blank glyphs (space) keep half a cell so words stay apart
+			if(start == end && g.present) { start = 0; end = (font.width + 1) / 2; }
+		}
+
+		p.offsets.push_back((uint16_t)p.columns.size());
+		p.widths.push_back((uint8_t)(end - start));
+		for(int x = start; x < end; ++x) p.columns.push_back(g.columns[x]);
+	}
+	if(p.columns.size() > 0xFFFF) fail("font is too large for 16 bit offsets");
+	return p;
+}
+
+static void printArray(const char* type, const std::string& name, const std::vector<uint8_t>& v)
+{
+	printf("static const %s %s[%u] PROGMEM = {", type, name.c_str(), (unsigned)v.size());
+	for(size_t i = 0; i < v.size(); ++i) printf("%s0x%02X", (i % 16) ? ", " : (i ? ",\n\t" : "\n\t"), v[i]);
+	printf("\n};\n\n");
+}
+
+static void emit(const Packed& p, const std::string& name, int height, int spacing, const char* source)
+{
+	printf("// Generated by tools/fontc from %s, characters %d-%d\n", source, p.first, p.last);
+	printf("#ifndef PACKED_FONT_%s_GUARD\n#define PACKED_FONT_%s_GUARD\n\n", name.c_str(), name.c_str());
+	printf("#include <avr/pgmspace.h>\n#include \"PackedFont.h\"\n\n");
+
+	printArray("uint8_t", name + "_widths", p.widths);
+
+	printf("static const uint16_t %s_offsets[%u] PROGMEM = {", name.c_str(), (unsigned)p.offsets.size());
+	for(size_t i = 0; i < p.offsets.size(); ++i) printf("%s%u", (i % 16) ? ", " : (i ? ",\n\t" : "\n\t"), p.offsets[i]);
+	printf("\n};\n\n");
+
+	printArray("uint8_t", name + "_columns", p.columns);
+
+	printf("static const PackedFont %s = { %d, %d, %d, %d, %s_widths, %s_offsets, %s_columns };\n\n",
+		name.c_str(), p.first, p.last, height, spacing, name.c_str(), name.c_str(), name.c_str());
+	printf("#endif\n");
+}
+
+// Draw a string with the packed data, exactly as DisplayToolbox::drawString lays it out
+static void preview(const Packed& p, int height, int spacing, const char* text)
+{
+	std::vector<uint8_t> frame;
+	for(const char* s = text; *s; ++s)
+	{
+		// Characters outside the font draw nothing but still get their spacing, as in drawString
+		int c = (uint8_t)*s;
+		if(c >= p.first && c <= p.last)
+		{
+			int i = c - p.first;
+			for(int x = 0; x < p.widths[i]; ++x) frame.push_back(p.columns[p.offsets[i] + x]);
+		}
+		if(s[1]) frame.insert(frame.end(), spacing, 0);
+	}
+
+	for(int y = 0; y < height; ++y)
+	{
+		for(size_t x = 0; x < frame.size(); ++x) fputc((frame[x] >> y) & 1 ? '#' : '.', stderr);
+		fputc('\n', stderr);
+	}
+}
+
+int main(int argc, char** argv)
+{
+	std::string name = "font";
+	int first = 32, last = 126, spacing = 1;
+	bool monospace = false;
+	const char* previewText = NULL;
+	const char* path = NULL;
+
+	for(int i = 1; i < argc; ++i)
+	{
+		std::string a = argv[i];
+		bool hasValue = i + 1 < argc;
+		if(a == "-n" && hasValue) name = argv[++i];
+		else if(a == "-f" && hasValue) first = atoi(argv[++i]);
+		else if(a == "-l" && hasValue) last = atoi(argv[++i]);
+		else if(a == "-s" && hasValue) spacing = atoi(argv[++i]);
+		else if(a == "-p" && hasValue) previewText = argv[++i];
+		else if(a == "-m") monospace = true;
+		else if(a[0] != '-') path = argv[i];
+		else fail("unknown option, see the top of fontc.cpp for usage");
+	}
+	if(!path) fail("usage: fontc [-n name] [-f first] [-l last] [-s spacing] [-m] [-p text] font.bdf|font.psf");
+	if(first < 0 || last > 255 || first > last) fail("bad character range");
+
+	std::ifstream in(path, std::ios::binary);
+	if(!in) fail("can't open the font");
+	std::vector<uint8_t> data((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+
+	Font font;
+	font.width = font.height = 0;
+	font.glyphs.resize(256);
+	if(!loadPsf(data, font) && !loadBdf(data, font)) fail("not a BDF or PSF font");
+	if(font.height > 8) fail("font is taller than 8 rows, it won't fit a panel");
+
+	// Drop the empty ends of the range so the table stays dense
+	while(first < last && !font.glyphs[first].present) ++first;
+	while(last > first && !font.glyphs[last].present) --last;
+
+	Packed p = pack(font, first, last, monospace);
+	emit(p, name, font.height, spacing, path);
+
+	size_t count = last - first + 1;
+	size_t packedBytes = p.widths.size() + p.offsets.size() * 2 + p.columns.size();
+	size_t fixedBytes = 128 * font.width; // font.h style, fixed cells for the whole 7 bit set
+	fprintf(stderr, "%s: %u glyphs (%d-%d), %dx%d cell\n", name.c_str(), (unsigned)count, first, last, font.width, font.height);
+	fprintf(stderr, "flash: %u bytes (widths %u, offsets %u, columns %u), fixed 128 glyph table would be %u\n",
+		(unsigned)packedBytes, (unsigned)p.widths.size(), (unsigned)p.offsets.size() * 2, (unsigned)p.columns.size(), (unsigned)fixedBytes);
+
+	if(previewText) preview(p, font.height, spacing, previewText);
+	return 0;
+}
@@ -0,0 +1,175 @@
+/*
+	MatrixDisplay Library 2.0 - Packed font check
+	Author: Miles Burton, www.milesburton.com/
+	Copyright (c) 2010 Miles Burton All Rights Reserved
+
+	This library is free software; you can redistribute it and/or
+	modify it under the terms of the GNU Lesser General Public
+	License as published by the Free Software Foundation; either
+	version 2.1 of the License, or (at your option) any later version.
+
+	This library is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+	Lesser General Public License for more details.
+
+	You should have received a copy of the GNU Lesser General Public
+	License along with this library; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+/*
+Draws sample strings in a fontc generated font (testfont.h, from testfont.bdf) with the library on
+the host simulator (tools/hostsim) and checks the columns:
+	DisplayToolbox::drawString   the back buffer has to hold the packed glyph columns, each followed
+	                             by the font's spacing, with trimmed and blank glyphs at their
+	                             packed widths and characters outside the font drawing nothing
+	Marquee                      after every step the zone has to show the same column stream
+	fontc -p                     the preview has to match what drawString drew (needs fontc)
+
+Build:   g++ -std=c++11 -I../hostsim -I../.. -o fontcheck fontcheck.cpp ../../DisplayToolbox.cpp ../../Marquee.cpp ../../MatrixDisplay.cpp ../hostsim/hostsim.cpp
+Usage:   fontcheck [path to fontc, default ./fontc]   run it from tools/fontc
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include "MatrixDisplay.h"
+#include "DisplayToolbox.h"
+#include "Marquee.h"
+#include "hostsim.h"
+#include "testfont.h"
+
+#define DISPLAYS    3
+#define CHAIN_WIDTH (32 * DISPLAYS)
+
+// Blank (space), trimmed ('.', '1', 'i'), hollow middle ('"'), full width ('A'), absent inside
+// the range ('B') and outside it ('z')
+static const char* samples[] = { "A1", "i.i", "A i", "\"A\"", "1B1", "Az.", " ", "iiii AAAA 1.1" };
+#define SAMPLE_COUNT (int)(sizeof(samples) / sizeof(samples[0]))
+
+// The string as fontc packed it: glyph columns from the header, spacing between characters
+static std::vector<uint8_t> packedColumns(const char* text)
+{
+	std::vector<uint8_t> columns;
+	for(const char* s = text; *s; ++s)
+	{
+		uint8_t c = (uint8_t)*s;
+		if(c >= testfont.firstChar && c <= testfont.lastChar)
+		{
+			int i = c - testfont.firstChar;
+			for(int x = 0; x < testfont_widths[i]; ++x) columns.push_back(testfont_columns[testfont_offsets[i] + x]);
+		}
+		if(s[1]) columns.insert(columns.end(), testfont.spacing, 0);
+	}
+	return columns;
+}
+
+static uint8_t chainColumn(MatrixDisplay& disp, int x)
+{
+	return disp.getBuffer(x / 32)[x % 32];
+}
+
+// Widths fontc should have trimmed the test glyphs to
+static int checkWidths()
+{
+	struct { char c; int width; } expected[] = { { ' ', 3 }, { '"', 3 }, { '.', 1 }, { '1', 3 }, { 'A', 5 }, { 'i', 3 }, { 'B', 0 } };
+	int failures = 0;
+	for(size_t i = 0; i < sizeof(expected) / sizeof(expected[0]); ++i)
+	{
+		int width = testfont_widths[expected[i].c - testfont.firstChar];
+		if(width != expected[i].width)
+		{
+			printf("  '%c' is %d columns, expected %d\n", expected[i].c, width, expected[i].width);
+			++failures;
+		}
+	}
+	return failures;
+}
+
+static int checkDrawString(const char* text, const std::vector<uint8_t>& want, int x0)
+{
+	MatrixDisplay disp(DISPLAYS, 11, 10);
+	DisplayToolbox toolbox(&disp);
+	
+	int width = toolbox.drawString(x0, 0, text, testfont);
+	int failures = width != (int)want.size() ? 1 : 0;
+	if(toolbox.getStringWidth(text, testfont) != (int)want.size()) ++failures;
+	
+	for(int x = 0; x < CHAIN_WIDTH; ++x)
+	{
+		int i = x - x0;
+		uint8_t expect = (i >= 0 && i < (int)want.size()) ? want[i] : 0;
+		if(chainColumn(disp, x) != expect) ++failures;
+	}
+	return failures;
+}
+
+static int checkMarquee(const char* text, const std::vector<uint8_t>& want)
+{
+	MatrixDisplay disp(DISPLAYS, 11, 10);
+	Marquee marquee(&disp, 0, CHAIN_WIDTH);
+	marquee.setFont(&testfont);
+	marquee.setText(text);
+	
+	// After n steps the zone holds stream columns n - CHAIN_WIDTH to n - 1, right aligned
+	int failures = 0;
+	for(int n = 1; n <= (int)want.size() + CHAIN_WIDTH && marquee.step(); ++n)
+	{
+		for(int x = 0; x < CHAIN_WIDTH; ++x)
+		{
+			int i = n - CHAIN_WIDTH + x;
+			uint8_t expect = (i >= 0 && i < (int)want.size()) ? want[i] : 0;
+			if(chainColumn(disp, x) != expect) ++failures;
+		}
+	}
+	return failures;
+}
+
+// fontc's -p preview, read back into columns
+static int checkPreview(const std::string& fontc, const char* text, const std::vector<uint8_t>& want)
+{
+	std::string command = fontc + " -f 32 -l 105 -p '" + text + "' testfont.bdf 2>&1 >/dev/null";
+	FILE* in = popen(command.c_str(), "r");
+	if(!in) return 1;
+	
+	std::vector<uint8_t> columns;
+	int row = 0;
+	char line[512];
+	while(fgets(line, sizeof(line), in))
+	{
+		std::string s = line;
+		if(s.find_first_not_of(".#\n") != std::string::npos) continue; // Summary lines
+		if(s.size() > 0 && s[s.size() - 1] == '\n') s.erase(s.size() - 1);
+		if(columns.size() < s.size()) columns.resize(s.size(), 0);
+		for(size_t x = 0; x < s.size(); ++x) if(s[x] == '#') columns[x] |= 1 << row;
+		++row;
+	}
+	if(pclose(in) != 0) return 1;
+	
+	// A blank string previews as empty lines
+	if(columns.size() != want.size()) return 1;
+	return columns == want ? 0 : 1;
+}
+
+int main(int argc, char** argv)
+{
+	std::string fontc = argc > 1 ? argv[1] : "./fontc";
+	int failures = checkWidths();
+	
+	for(int i = 0; i < SAMPLE_COUNT; ++i)
+	{
+		std::vector<uint8_t> want = packedColumns(samples[i]);
+		int drawn = checkDrawString(samples[i], want, 0) + checkDrawString(samples[i], want, 29);
+		int scrolled = checkMarquee(samples[i], want);
+		int preview = checkPreview(fontc, samples[i], want);
+		printf("\"%s\": %d columns, drawString %d, Marquee %d, preview %d differ\n",
+			samples[i], (int)want.size(), drawn, scrolled, preview);
+		failures += drawn + scrolled + preview;
+	}
+	
+	printf("%s\n", failures ? "FAILED" : "passed");
+	return failures ? 1 : 0;
+}
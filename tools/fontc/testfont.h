@@ -0,0 +1,31 @@
+// Generated by tools/fontc from testfont.bdf, characters 32-105
+#ifndef PACKED_FONT_testfont_GUARD
+#define PACKED_FONT_testfont_GUARD
+
+#include <avr/pgmspace.h>
+#include "PackedFont.h"
+
+static const uint8_t testfont_widths[74] PROGMEM = {
+	0x03, 0x00, 0x03, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x01, 0x00,
+	0x00, 0x03, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+	0x00, 0x05, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x03
+};
+
+static const uint16_t testfont_offsets[74] PROGMEM = {
+	0, 3, 3, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 7,
+	7, 7, 10, 10, 10, 10, 10, 10, 10, 10, 10, 10, 10, 10, 10, 10,
+	10, 10, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15,
+	15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15,
+	15, 15, 15, 15, 15, 15, 15, 15, 15, 15
+};
+
+static const uint8_t testfont_columns[18] PROGMEM = {
+	0x00, 0x00, 0x00, 0x03, 0x00, 0x03, 0x20, 0x22, 0x3F, 0x20, 0x3E, 0x09, 0x09, 0x09, 0x3E, 0x24,
+	0x3D, 0x20
+};
+
+static const PackedFont testfont = { 32, 105, 7, 1, testfont_widths, testfont_offsets, testfont_columns };
+
+#endif
@@ -0,0 +1,43 @@
+/*
+	MatrixDisplay Library 2.0 - Host build stubs
+	Author: Miles Burton, www.milesburton.com/
+	Copyright (c) 2010 Miles Burton All Rights Reserved
+
+	This library is free software; you can redistribute it and/or
+	modify it under the terms of the GNU Lesser General Public
+	License as published by the Free Software Foundation; either
+	version 2.1 of the License, or (at your option) any later version.
+
+	This library is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+	Lesser General Public License for more details.
+
+	You should have received a copy of the GNU Lesser General Public
+	License along with this library; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#ifndef HOSTSIM_SERIAL_GUARD
+#define HOSTSIM_SERIAL_GUARD
+
+#include <stdint.h>
+
+#define DEC 10
+#define HEX 16
+
+// Serial output goes nowhere, input is always empty
+struct HardwareSerial
+{
+	void print(const char* text);
+	void print(int value, int base = DEC);
+	void println(const char* text);
+	void println(int value, int base = DEC);
+	int available();
+	int read();
+	void write(uint8_t value);
+};
+
+extern HardwareSerial Serial;
+
+#endif
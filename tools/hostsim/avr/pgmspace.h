@@ -0,0 +1,36 @@
+/*
+	MatrixDisplay Library 2.0 - Host build stubs
+	Author: Miles Burton, www.milesburton.com/
+	Copyright (c) 2010 Miles Burton All Rights Reserved
+
+	This library is free software; you can redistribute it and/or
+	modify it under the terms of the GNU Lesser General Public
+	License as published by the Free Software Foundation; either
+	version 2.1 of the License, or (at your option) any later version.
+
+	This library is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+	Lesser General Public License for more details.
+
+	You should have received a copy of the GNU Lesser General Public
+	License along with this library; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#ifndef HOSTSIM_PGMSPACE_GUARD
+#define HOSTSIM_PGMSPACE_GUARD
+
+#include <stdint.h>
+#include <string.h>
+
+// Flash is ordinary memory on the host
+#define PROGMEM
+#define PSTR(s) (s)
+#define pgm_read_byte(p)       (*(const uint8_t*)(p))
+#define pgm_read_byte_near(p)  (*(const uint8_t*)(p))
+#define pgm_read_word(p)       (*(const uint16_t*)(p))
+#define pgm_read_word_near(p)  (*(const uint16_t*)(p))
+#define memcpy_P(d, s, n)      memcpy((d), (s), (n))
+
+#endif
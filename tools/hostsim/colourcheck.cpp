@@ -0,0 +1,90 @@
+/*
+	MatrixDisplay Library 2.0 - Colour readback check
+	Author: Miles Burton, www.milesburton.com/
+	Copyright (c) 2010 Miles Burton All Rights Reserved
+
+	This library is free software; you can redistribute it and/or
+	modify it under the terms of the GNU Lesser General Public
+	License as published by the Free Software Foundation; either
+	version 2.1 of the License, or (at your option) any later version.
+
+	This library is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+	Lesser General Public License for more details.
+
+	You should have received a copy of the GNU Lesser General Public
+	License along with this library; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+/*
+Draws every pixel of a chain through DisplayToolbox in a pattern of colours and reads each one back
+with DisplayToolbox::getPixel(), on mono panels and on bi-colour panels where each colour plane is
+16 columns wide, so chain columns past the first plane have to land on the right display and plane.
+
+Build:   g++ -std=c++11 -I. -I../.. -o colourcheck colourcheck.cpp ../../MatrixDisplay.cpp ../../DisplayToolbox.cpp hostsim.cpp
+Usage:   colourcheck
+*/
+
+#include <stdio.h>
+#include "MatrixDisplay.h"
+#include "DisplayToolbox.h"
+#include "hostsim.h"
+
+#define DISPLAYS 3
+
+// Colour of pixel (x, y) in the test pattern, all four values on every display and plane
+static uint8_t patternColour(int x, int y, bool bicolour)
+{
+	return bicolour ? (uint8_t)((x + y * 3) & 3) : (uint8_t)((x ^ y) & 1);
+}
+
+static int check(bool bicolour)
+{
+	MatrixDisplay disp(DISPLAYS, 11, 10);
+	disp.setColourMode(bicolour);
+	DisplayToolbox toolbox(&disp);
+	int width = disp.getDisplayWidth() * DISPLAYS;
+	
+	for(int y = 0; y < 8; ++y)
+	{
+		for(int x = 0; x < width; ++x)
+		{
+			uint8_t colour = patternColour(x, y, bicolour);
+			if(bicolour && colour) toolbox.setColour(colour);
+			toolbox.setPixel(x, y, colour ? ROP_SET : ROP_CLEAR);
+		}
+	}
+	
+	int mismatches = 0;
+	for(int y = 0; y < 8; ++y)
+	{
+		for(int x = 0; x < width; ++x)
+		{
+			uint8_t want = patternColour(x, y, bicolour);
+			uint8_t got = toolbox.getPixel(x, y, false);
+			
+			// The library's own per display read tells a drawing fault from a readback fault
+			uint8_t stored = disp.getPixel(x / disp.getDisplayWidth(), x % disp.getDisplayWidth(), y);
+			if(got != want || stored != want)
+			{
+				if(mismatches < 8) printf("  (%d, %d): drew %d, stored %d, read back %d\n", x, y, want, stored, got);
+				++mismatches;
+			}
+		}
+	}
+	
+	// Past the end of the chain reads as off
+	if(toolbox.getPixel(width, 0, false) != 0 || toolbox.getPixel(-1, 0, false) != 0) ++mismatches;
+	
+	printf("%s: %d pixels differ\n", bicolour ? "bi-colour" : "mono", mismatches);
+	return mismatches;
+}
+
+int main()
+{
+	int failures = check(false) + check(true);
+	printf("%s\n", failures ? "FAILED" : "passed");
+	return failures ? 1 : 0;
+}
@@ -0,0 +1,235 @@
+/*
+	MatrixDisplay Library 2.0 - Host build stubs
+	Author: Miles Burton, www.milesburton.com/
+	Copyright (c) 2010 Miles Burton All Rights Reserved
+
+	This library is free software; you can redistribute it and/or
+	modify it under the terms of the GNU Lesser General Public
+	License as published by the Free Software Foundation; either
+	version 2.1 of the License, or (at your option) any later version.
+
+	This library is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+	Lesser General Public License for more details.
+
+	You should have received a copy of the GNU Lesser General Public
+	License along with this library; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+
+#include "hostsim.h"
+#include "wiring.h"
+#include "HardwareSerial.h"
+#include "avr/eeprom.h"
+#include <string.h>
+
+HostsimPort PORTA, PORTB, PORTC, PORTD;
+volatile uint8_t SREG;
+
+uint8_t hostsimEeprom[HOSTSIM_EEPROM_SIZE];
+int hostsimRead = 0;
+unsigned long hostsimMicros = 0;
+
+HardwareSerial Serial;
+
+static bool watching = false;
+static uint8_t busClkPin;
+static uint8_t busDataPin;
+static bool lastClk;
+static uint32_t lastPins; // Bit n = level of pin n
+static std::vector<uint8_t> busBits[HOSTSIM_PINS];
+static unsigned long clockEdges;
+static unsigned long transactions[HOSTSIM_PINS];
+
+// What an HT1632 makes of the bits clocked in while its CS is low
+struct Panel
+{
+	uint16_t bitCount; // In this transaction
+	uint8_t id;
+	uint8_t address;
+	uint8_t nibble;
+	uint8_t ram[HOSTSIM_PANEL_RAM];
+};
+static Panel panels[HOSTSIM_PINS];
+
+///////////////////////////////////////////////////////////////////////////////
+//  PINS & BUS
+//
+bool hostsimPin(uint8_t pin)
+{
+	if(pin < 8) return (PORTD.value >> pin) & 1;
+	if(pin < 14) return (PORTB.value >> (pin - 8)) & 1;
+	return (PORTC.value >> (pin - 14)) & 1;
+}
+
+static uint32_t readPins()
+{
+	uint32_t pins = 0;
+	for(uint8_t pin = 0; pin < HOSTSIM_PINS; ++pin) pins |= (uint32_t)hostsimPin(pin) << pin;
+	return pins;
+}
+
+void hostsimWatchBus(uint8_t clkPin, uint8_t dataPin)
+{
+	watching = true;
+	busClkPin = clkPin;
+	busDataPin = dataPin;
+	lastClk = hostsimPin(clkPin);
+	lastPins = readPins();
+	clockEdges = 0;
+	for(uint8_t pin = 0; pin < HOSTSIM_PINS; ++pin)
+	{
+		busBits[pin].clear();
+		transactions[pin] = 0;
+	}
+}
+
+const std::vector<uint8_t>& hostsimBusBits(uint8_t pin)
+{
+	return busBits[pin % HOSTSIM_PINS];
+}
+
+unsigned long hostsimClockEdges()
+{
+	return clockEdges;
+}
+
+unsigned long hostsimTransactions(uint8_t pin)
+{
+	return transactions[pin % HOSTSIM_PINS];
+}
+
+const uint8_t* hostsimPanelRam(uint8_t pin)
+{
+	return panels[pin % HOSTSIM_PINS].ram;
+}
+
+void hostsimClearPanels()
+{
+	for(uint8_t pin = 0; pin < HOSTSIM_PINS; ++pin) memset(panels[pin].ram, 0, HOSTSIM_PANEL_RAM);
+}
+
+// ID (3 bits, MSB first), then for a write the address (7 bits, MSB first) and nybbles LSB first
+// to successive addresses. Commands and reads leave the RAM alone
+static void panelBit(Panel& panel, uint8_t bit)
+{
+	uint16_t n = panel.bitCount++;
+	if(n < 3)
+	{
+		panel.id = (panel.id << 1) | bit;
+		return;
+	}
+	if(panel.id != 5) return;
+	
+	if(n < 10)
+	{
+		panel.address = (panel.address << 1) | bit;
+		return;
+	}
+	
+	uint8_t nibbleBit = (n - 10) & 3;
+	panel.nibble |= bit << nibbleBit;
+	if(nibbleBit == 3)
+	{
+		panel.ram[panel.address & (HOSTSIM_PANEL_RAM - 1)] = panel.nibble;
+		++panel.address;
+		panel.nibble = 0;
+	}
+}
+
+// Called on every port write, the panels latch data on the rising clock edge
+static void sampleBus()
+{
+	if(!watching) return;
+	
+	// A CS going low starts a transaction
+	uint32_t pins = readPins();
+	uint32_t fallen = lastPins & ~pins;
+	lastPins = pins;
+	for(uint8_t pin = 0; pin < HOSTSIM_PINS; ++pin)
+	{
+		if(pin == busClkPin || pin == busDataPin || !(fallen & (1UL << pin))) continue;
+		Panel& panel = panels[pin];
+		panel.bitCount = 0;
+		panel.id = 0;
+		panel.address = 0;
+		panel.nibble = 0;
+		++transactions[pin];
+	}
+	
+	bool clk = hostsimPin(busClkPin);
+	if(clk && !lastClk)
+	{
+		uint8_t data = hostsimPin(busDataPin);
+		bool selected = false;
+		for(uint8_t pin = 0; pin < HOSTSIM_PINS; ++pin)
+		{
+			if(pin == busClkPin || pin == busDataPin || hostsimPin(pin)) continue;
+			busBits[pin].push_back(data);
+			panelBit(panels[pin], data);
+			selected = true;
+		}
+		if(selected) ++clockEdges;
+	}
+	lastClk = clk;
+}
+
+HostsimPort& HostsimPort::operator|=(uint8_t bits)
+{
+	value |= bits;
+	sampleBus();
+	return *this;
+}
+
+HostsimPort& HostsimPort::operator&=(uint8_t bits)
+{
+	value &= bits;
+	sampleBus();
+	return *this;
+}
+
+HostsimPort& HostsimPort::operator=(uint8_t bits)
+{
+	value = bits;
+	sampleBus();
+	return *this;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//  WIRING
+//
+void pinMode(uint8_t, uint8_t) {}
+void digitalWrite(uint8_t, uint8_t) {}
+int digitalRead(uint8_t) { return hostsimRead; }
+
+unsigned long millis() { return hostsimMicros / 1000; }
+unsigned long micros() { return hostsimMicros; }
+void delay(unsigned long ms) { hostsimMicros += ms * 1000; }
+void delayMicroseconds(unsigned int us) { hostsimMicros += us; }
+long random(long low, long) { return low; }
+
+///////////////////////////////////////////////////////////////////////////////
+//  SERIAL
+//
+void HardwareSerial::print(const char*) {}
+void HardwareSerial::print(int, int) {}
+void HardwareSerial::println(const char*) {}
+void HardwareSerial::println(int, int) {}
+int HardwareSerial::available() { return 0; }
+int HardwareSerial::read() { return -1; }
+void HardwareSerial::write(uint8_t) {}
+
+///////////////////////////////////////////////////////////////////////////////
+//  EEPROM
+//
+uint8_t eeprom_read_byte(const uint8_t* address)
+{
+	return hostsimEeprom[(uintptr_t)address % HOSTSIM_EEPROM_SIZE];
+}
+
+void eeprom_write_byte(uint8_t* address, uint8_t value)
+{
+	hostsimEeprom[(uintptr_t)address % HOSTSIM_EEPROM_SIZE] = value;
+}
@@ -0,0 +1,66 @@
+/*
+	MatrixDisplay Library 2.0 - Host build stubs
+	Author: Miles Burton, www.milesburton.com/
+	Copyright (c) 2010 Miles Burton All Rights Reserved
+
+	This library is free software; you can redistribute it and/or
+	modify it under the terms of the GNU Lesser General Public
+	License as published by the Free Software Foundation; either
+	version 2.1 of the License, or (at your option) any later version.
+
+	This library is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+	Lesser General Public License for more details.
+
+	You should have received a copy of the GNU Lesser General Public
+	License along with this library; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+/*
+Builds the library on a PC so the host tools can check their output against the real thing.
+
+Build:   g++ -std=c++11 -I../hostsim -I../.. mycheck.cpp ../../MatrixDisplay.cpp ../hostsim/hostsim.cpp
+
+The pins go nowhere, time only moves when the library waits (delay, delayMicroseconds) and reads
+return hostsimRead. After hostsimWatchBus() every bit clocked in (rising clock edge) is recorded
+against each pin which is low at the time, so hostsimBusBits(csPin) is what that display was sent.
+Each pin also drives a model of an HT1632's RAM, decoding the write (ID 101) transactions clocked in
+while it's low, so hostsimPanelRam(csPin) is what that display shows.
+Pin numbers follow the ATmega328 mapping MatrixDisplay::bitBlast uses (0-7 PORTD, 8-13 PORTB,
+14-19 PORTC).
+*/
+
+#ifndef HOSTSIM_GUARD
+#define HOSTSIM_GUARD
+
+#include <stdint.h>
+#include <vector>
+
+#define HOSTSIM_EEPROM_SIZE 1024
+#define HOSTSIM_PINS        20
+#define HOSTSIM_PANEL_RAM   128 // Nybble addresses, the 7 bit address space
+
+extern uint8_t hostsimEeprom[HOSTSIM_EEPROM_SIZE];
+extern int hostsimRead; // What digitalRead() returns
+extern unsigned long hostsimMicros; // The clock behind millis() and micros()
+
+// Start recording the bus, forgets anything recorded so far
+void hostsimWatchBus(uint8_t clkPin, uint8_t dataPin);
+
+// Level of a pin
+bool hostsimPin(uint8_t pin);
+
+// Bits clocked in while pin was low, in order
+const std::vector<uint8_t>& hostsimBusBits(uint8_t pin);
+
+// Rising clock edges seen while any pin was low, and how often each pin went low (transactions)
+unsigned long hostsimClockEdges();
+unsigned long hostsimTransactions(uint8_t pin);
+
+// RAM of the panel selected by pin, one nybble per address. Kept across hostsimWatchBus()
+const uint8_t* hostsimPanelRam(uint8_t pin);
+void hostsimClearPanels();
+
+#endif
@@ -0,0 +1,113 @@
+/*
+	MatrixDisplay Library 2.0 - Frame scheduler check
+	Author: Miles Burton, www.milesburton.com/
+	Copyright (c) 2010 Miles Burton All Rights Reserved
+
+	This library is free software; you can redistribute it and/or
+	modify it under the terms of the GNU Lesser General Public
+	License as published by the Free Software Foundation; either
+	version 2.1 of the License, or (at your option) any later version.
+
+	This library is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+	Lesser General Public License for more details.
+
+	You should have received a copy of the GNU Lesser General Public
+	License along with this library; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+/*
+Drives FrameScheduler from a fake clock through a fixed script of late, early and slow frames and
+checks the callbacks and statistics after every tick(): catching up several steps in one tick,
+dropping time once maxCatchUp is reached, skipping the render when the updates ran past the next
+step, handing early ticks to idle(), and doing nothing at all while there's no clock.
+
+Build:   g++ -std=c++11 -I. -I../.. -o schedcheck schedcheck.cpp ../../FrameScheduler.cpp
+Usage:   schedcheck
+*/
+
+#include <stdio.h>
+#include "FrameScheduler.h"
+
+#define FPS    100
+#define PERIOD (1000000UL / FPS)
+
+static unsigned long fakeNow;
+static unsigned long updateCost; // Time each update() takes
+static unsigned long updates, renders, idles;
+
+static unsigned long fakeClock() { return fakeNow; }
+static void update() { ++updates; fakeNow += updateCost; }
+static void render() { ++renders; }
+static void idle() { ++idles; }
+
+struct Step
+{
+	const char* what;
+	unsigned long now; // Clock at the tick
+	unsigned long cost; // Of each update
+	uint8_t maxCatchUp; // 0 = leave as is
+	// Totals expected afterwards
+	unsigned long updates, renders, idles, skipped, overruns;
+};
+
+static const Step script[] = {
+	{ "first tick starts the time base",   0,                0,              0, 1,  1, 0, 0, 0 },
+	{ "early tick goes to idle",           PERIOD / 2,       0,              0, 1,  1, 1, 0, 0 },
+	{ "on time",                           PERIOD,           0,              0, 2,  2, 1, 0, 0 },
+	{ "late, catches up three steps",      PERIOD * 9 / 2,   0,              0, 5,  3, 1, 0, 0 },
+	{ "still early",                       PERIOD * 49 / 10, 0,              0, 5,  3, 2, 0, 0 },
+	{ "ten late is clamped to two",        PERIOD * 15,      0,              2, 7,  4, 2, 0, 1 },
+	{ "after the drop the next is due",    PERIOD * 16,      0,              0, 8,  5, 2, 0, 1 },
+	{ "slow update skips the render",      PERIOD * 17,      PERIOD * 3 / 2, 0, 9,  5, 2, 1, 1 },
+	{ "back on time",                      PERIOD * 37 / 2,  0,              0, 10, 6, 2, 1, 1 },
+};
+
+int main()
+{
+	int failures = 0;
+	
+	// No clock, nothing may run (and nothing may call through a NULL clock)
+	FrameScheduler idleScheduler(FPS, update, render, idle);
+	idleScheduler.reset();
+	for(int i = 0; i < 3; ++i) idleScheduler.tick();
+	if(updates || renders || idles || idleScheduler.getFrameCount())
+	{
+		printf("  ran without a clock\n");
+		++failures;
+	}
+	
+	FrameScheduler scheduler(FPS, update, render, idle);
+	scheduler.setClock(fakeClock);
+	
+	for(size_t i = 0; i < sizeof(script) / sizeof(script[0]); ++i)
+	{
+		const Step& s = script[i];
+		fakeNow = s.now;
+		updateCost = s.cost;
+		if(s.maxCatchUp) scheduler.setMaxCatchUp(s.maxCatchUp);
+		scheduler.tick();
+		
+		bool ok = updates == s.updates && renders == s.renders && idles == s.idles
+			&& scheduler.getFrameCount() == updates && scheduler.getRenderCount() == renders
+			&& scheduler.getSkippedRenders() == s.skipped && scheduler.getOverruns() == s.overruns;
+		if(!ok)
+		{
+			printf("  %s: updates %lu renders %lu idles %lu skipped %lu overruns %lu\n", s.what,
+				updates, renders, idles, scheduler.getSkippedRenders(), scheduler.getOverruns());
+			++failures;
+		}
+	}
+	
+	// The clamped tick was the latest
+	if(scheduler.getMaxJitter() != PERIOD * 10)
+	{
+		printf("  max jitter %lu\n", scheduler.getMaxJitter());
+		++failures;
+	}
+	
+	printf("%s\n", failures ? "FAILED" : "passed");
+	return failures ? 1 : 0;
+}
@@ -0,0 +1,102 @@
+/*
+	MatrixDisplay Library 2.0 - Sync cost check
+	Author: Miles Burton, www.milesburton.com/
+	Copyright (c) 2010 Miles Burton All Rights Reserved
+
+	This library is free software; you can redistribute it and/or
+	modify it under the terms of the GNU Lesser General Public
+	License as published by the Free Software Foundation; either
+	version 2.1 of the License, or (at your option) any later version.
+
+	This library is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+	Lesser General Public License for more details.
+
+	You should have received a copy of the GNU Lesser General Public
+	License along with this library; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+/*
+Runs syncChanges() over random edits, once planning from the dirty columns and once from a copy of
+the panels' RAM (trackPanelContents), on mono and bi-colour chains. After each sync the clock edges
+seen on the bus must equal getLastSyncBits() and every panel's RAM must match the back buffer.
+Sparse and dense edits are mixed so both the run plan and the full write fallback get used.
+
+Build:   g++ -std=c++11 -I. -I../.. -o synccheck synccheck.cpp ../../MatrixDisplay.cpp hostsim.cpp
+Usage:   synccheck
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "MatrixDisplay.h"
+#include "hostsim.h"
+
+#define DISPLAYS 3
+#define ROUNDS   200
+
+static const uint8_t csPins[] = { 2, 3, 4, 5, 6, 7, 8, 9 };
+
+static int check(bool bicolour, bool tracked)
+{
+	MatrixDisplay disp(DISPLAYS, 11, 10);
+	disp.initDisplays(csPins, 0);
+	disp.setColourMode(bicolour);
+	hostsimClearPanels();
+	
+	// Start from a known panel state, the tracked copy begins as what was last written
+	disp.trackPanelContents(tracked);
+	disp.syncDisplays();
+	
+	uint8_t size = disp.getDisplayWidth() * disp.getPlaneCount();
+	int failures = 0;
+	unsigned long planned = 0;
+	srand(tracked ? 38 : 83);
+	
+	for(int round = 0; round < ROUNDS; ++round)
+	{
+		// Edit a few nybbles, or most of a display now and then
+		int edits = (round % 7 == 0) ? 40 : 1 + rand() % 6;
+		for(int i = 0; i < edits; ++i)
+		{
+			uint8_t d = rand() % DISPLAYS;
+			uint8_t x = rand() % size;
+			uint8_t* pCol = disp.getBuffer(d) + x;
+			*pCol ^= (rand() & 1) ? 0x0F : (uint8_t)rand();
+			if(!tracked) disp.markDirty(d, x);
+		}
+		
+		hostsimWatchBus(11, 10);
+		disp.syncChanges();
+		planned += disp.getLastSyncBits();
+		
+		if(hostsimClockEdges() != disp.getLastSyncBits())
+		{
+			if(failures < 8) printf("  round %d: planned %lu bits, clocked %lu\n", round, disp.getLastSyncBits(), hostsimClockEdges());
+			++failures;
+		}
+		for(uint8_t d = 0; d < DISPLAYS; ++d)
+		{
+			const uint8_t* ram = hostsimPanelRam(csPins[d]);
+			const uint8_t* pBuffer = disp.getBuffer(d);
+			for(uint8_t x = 0; x < size; ++x)
+			{
+				if(ram[x << 1] == (pBuffer[x] & 0x0F) && ram[(x << 1) + 1] == (pBuffer[x] >> 4)) continue;
+				if(failures < 8) printf("  round %d: display %d column %d is stale\n", round, d, x);
+				++failures;
+			}
+		}
+	}
+	
+	printf("%s, %s: %lu bits planned, %d failures\n", bicolour ? "bi-colour" : "mono",
+		tracked ? "tracked" : "dirty map", planned, failures);
+	return failures;
+}
+
+int main()
+{
+	int failures = check(false, false) + check(false, true) + check(true, false) + check(true, true);
+	printf("%s\n", failures ? "FAILED" : "passed");
+	return failures ? 1 : 0;
+}
@@ -0,0 +1,64 @@
+/*
+	MatrixDisplay Library 2.0 - Host build stubs
+	Author: Miles Burton, www.milesburton.com/
+	Copyright (c) 2010 Miles Burton All Rights Reserved
+
+	This library is free software; you can redistribute it and/or
+	modify it under the terms of the GNU Lesser General Public
+	License as published by the Free Software Foundation; either
+	version 2.1 of the License, or (at your option) any later version.
+
+	This library is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+	Lesser General Public License for more details.
+
+	You should have received a copy of the GNU Lesser General Public
+	License along with this library; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+// Just enough of the Arduino core to build the library on a PC for the host tools' checks,
+// see hostsim.h. Nothing here drives real pins
+
+#ifndef HOSTSIM_WIRING_GUARD
+#define HOSTSIM_WIRING_GUARD
+
+#include <stdint.h>
+
+typedef bool boolean;
+typedef uint8_t byte;
+
+#define OUTPUT 1
+#define INPUT  0
+#define HIGH   1
+#define LOW    0
+
+// Ports tell hostsim.cpp when they change, so it can record what's clocked out on the bus
+struct HostsimPort
+{
+	uint8_t value;
+	
+	HostsimPort& operator|=(uint8_t bits);
+	HostsimPort& operator&=(uint8_t bits);
+	HostsimPort& operator=(uint8_t bits);
+	operator uint8_t() const { return value; }
+};
+
+extern HostsimPort PORTA, PORTB, PORTC, PORTD;
+extern volatile uint8_t SREG;
+
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t value);
+int digitalRead(uint8_t pin);
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+long random(long low, long high);
+
+#define noInterrupts()
+#define interrupts()
+#define cli()
+
+#endif
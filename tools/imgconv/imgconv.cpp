@@ -0,0 +1,351 @@
+/*
+	MatrixDisplay Library 2.0 - Image converter
+	Author: Miles Burton, www.milesburton.com/
+	Copyright (c) 2010 Miles Burton All Rights Reserved
+
+	This library is free software; you can redistribute it and/or
+	modify it under the terms of the GNU Lesser General Public
+	License as published by the Free Software Foundation; either
+	version 2.1 of the License, or (at your option) any later version.
+
+	This library is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+	Lesser General Public License for more details.
+
+	You should have received a copy of the GNU Lesser General Public
+	License along with this library; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+/*
+Host tool, converts PPM/PGM images (or a whole clip of them) into frames in the display buffer
+layout, ready for MatrixDisplay::syncFrom() or a TripleBuffer.
+
+Build:   g++ -O2 -std=c++11 -pthread -o imgconv imgconv.cpp
+Usage:   imgconv [options] image.ppm ... > frames.h
+	-x across    Panels across (default: 1)
+	-y down      Panels down (default: 1)
+	-d mode      threshold, ordered (8x8 Bayer) or fs (Floyd-Steinberg), default: fs
+	-t level     Threshold / brightness bias, 0-255 (default: 128)
+	-i           Invert
+	-j threads   Worker threads (default: all cores)
+	-b file      Write raw frames to file instead of a header
+	-n name      C name for the header (default: frames)
+	-p           Print every frame to stderr
+
+Inputs may hold several images back to back, e.g. a clip from
+	ffmpeg -i clip.mp4 -f image2pipe -vcodec ppm clip.ppm
+Images are box filtered to the layout's size (32 x 8 per panel) whatever size they come in.
+
+Layout: display n is panel (n % across, n / across), left to right then top to bottom. Each frame
+is 32 bytes per display, display 0 first. Byte x of a display is column x, bit y is row y, the
+same as MatrixDisplay::setPixel(n, x, y, 1) would set in the back buffer.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <ctype.h>
+#include <string>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <fstream>
+
+// Must match MatrixDisplay
+#define PANEL_WIDTH  32
+#define PANEL_HEIGHT 8
+
+enum Dither { DITHER_THRESHOLD, DITHER_ORDERED, DITHER_FS };
+
+struct Image
+{
+	int width;
+	int height;
+	std::vector<uint8_t> grey; // Row major
+};
+
+struct Options
+{
+	int across;
+	int down;
+	Dither dither;
+	int level;
+	bool invert;
+};
+
+static void fail(const char* msg)
+{
+	fprintf(stderr, "imgconv: %s\n", msg);
+	exit(1);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//  INPUT
+//
+static void skipSpace(const std::vector<uint8_t>& data, size_t& pos)
+{
+	while(pos < data.size())
+	{
+		if(data[pos] == '#') while(pos < data.size() && data[pos] != '\n') ++pos;
+		else if(isspace(data[pos])) ++pos;
+		else break;
+	}
+}
+
+static int readNumber(const std::vector<uint8_t>& data, size_t& pos)
+{
+	skipSpace(data, pos);
+	if(pos >= data.size() || !isdigit(data[pos])) fail("bad PPM/PGM header");
+	int value = 0;
+	while(pos < data.size() && isdigit(data[pos])) value = value * 10 + (data[pos++] - '0');
+	return value;
+}
+
+// P2/P3 (ASCII) and P5/P6 (binary), 8 or 16 bit, as many images as the data holds
+static void loadImages(const std::vector<uint8_t>& data, std::vector<Image>& images)
+{
+	size_t pos = 0;
+	for(;;)
+	{
+		skipSpace(data, pos);
+		if(pos >= data.size()) break;
+		if(pos + 2 > data.size() || data[pos] != 'P') fail("not a PPM or PGM image");
+		
+		char type = data[pos + 1];
+		if(type != '2' && type != '3' && type != '5' && type != '6') fail("only P2, P3, P5 and P6 are supported");
+		pos += 2;
+		
+		Image img;
+		img.width = readNumber(data, pos);
+		img.height = readNumber(data, pos);
+		int maxValue = readNumber(data, pos);
+		if(img.width <= 0 || img.height <= 0 || maxValue <= 0 || maxValue > 65535) fail("bad image size");
+		
+		bool colour = type == '3' || type == '6';
+		bool binary = type == '5' || type == '6';
+		int channels = colour ? 3 : 1;
+		int sampleBytes = maxValue > 255 ? 2 : 1;
+		if(binary) ++pos; // Single whitespace before the raster
+		
+		size_t pixels = (size_t)img.width * img.height;
+		if(binary && pos + pixels * channels * sampleBytes > data.size()) fail("image is cut short");
+		
+		img.grey.resize(pixels);
+		for(size_t i = 0; i < pixels; ++i)
+		{
+			int sample[3];
+			for(int c = 0; c < channels; ++c)
+			{
+				if(!binary) sample[c] = readNumber(data, pos);
+				else if(sampleBytes == 2) { sample[c] = (data[pos] << 8) | data[pos + 1]; pos += 2; }
+				else sample[c] = data[pos++];
+			}
+			
+			// Rec. 601 luma
+			int luma = colour ? (sample[0] * 299 + sample[1] * 587 + sample[2] * 114) / 1000 : sample[0];
+			img.grey[i] = (uint8_t)((luma * 255 + maxValue / 2) / maxValue);
+		}
+		images.push_back(img);
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//  CONVERSION
+//
+// Average of the source pixels covering each target pixel
+static std::vector<int> resample(const Image& img, int width, int height)
+{
+	std::vector<int> out((size_t)width * height);
+	for(int y = 0; y < height; ++y)
+	{
+		int y0 = (int)((long)y * img.height / height);
+		int y1 = (int)((long)(y + 1) * img.height / height);
+		if(y1 <= y0) y1 = y0 + 1;
+		for(int x = 0; x < width; ++x)
+		{
+			int x0 = (int)((long)x * img.width / width);
+			int x1 = (int)((long)(x + 1) * img.width / width);
+			if(x1 <= x0) x1 = x0 + 1;
+			
+			long total = 0;
+			for(int sy = y0; sy < y1; ++sy)
+			{
+				for(int sx = x0; sx < x1; ++sx) total += img.grey[(size_t)sy * img.width + sx];
+			}
+			out[(size_t)y * width + x] = (int)(total / ((long)(x1 - x0) * (y1 - y0)));
+		}
+	}
+	return out;
+}
+
+static const uint8_t bayer8[8][8] = {
+	{  0, 32,  8, 40,  2, 34, 10, 42 }, { 48, 16, 56, 24, 50, 18, 58, 26 },
+	{ 12, 44,  4, 36, 14, 46,  6, 38 }, { 60, 28, 52, 20, 62, 30, 54, 22 },
+	{  3, 35, 11, 43,  1, 33,  9, 41 }, { 51, 19, 59, 27, 49, 17, 57, 25 },
+	{ 15, 47,  7, 39, 13, 45,  5, 37 }, { 63, 31, 55, 23, 61, 29, 53, 21 }
+};
+
+// One image to one frame, lit pixels are set the way MatrixDisplay::setPixel() sets them
+static std::vector<uint8_t> convert(const Image& img, const Options& opt)
+{
+	int width = opt.across * PANEL_WIDTH;
+	int height = opt.down * PANEL_HEIGHT;
+	std::vector<int> grey = resample(img, width, height);
+	std::vector<uint8_t> frame((size_t)opt.across * opt.down * PANEL_WIDTH, 0);
+	
+	// Shift the midpoint so -t works as a brightness control for the dithered modes too
+	int bias = 128 - opt.level;
+	
+	for(int y = 0; y < height; ++y)
+	{
+		for(int x = 0; x < width; ++x)
+		{
+			int value = grey[(size_t)y * width + x];
+			if(opt.invert) value = 255 - value;
+			
+			bool lit;
+			if(opt.dither == DITHER_THRESHOLD)
+			{
+				lit = value >= opt.level;
+			}
+			else if(opt.dither == DITHER_ORDERED)
+			{
+				lit = value + bias > bayer8[y & 7][x & 7] * 4 + 2;
+			}
+			else
+			{
+				// Floyd-Steinberg, error carried right and down in the working copy
+				int want = value + bias;
+				lit = want >= 128;
+				int error = want - (lit ? 255 : 0);
+				if(x + 1 < width) grey[(size_t)y * width + x + 1] += error * 7 / 16;
+				if(y + 1 < height)
+				{
+					if(x > 0) grey[(size_t)(y + 1) * width + x - 1] += error * 3 / 16;
+					grey[(size_t)(y + 1) * width + x] += error * 5 / 16;
+					if(x + 1 < width) grey[(size_t)(y + 1) * width + x + 1] += error / 16;
+				}
+			}
+			
+			if(!lit) continue;
+			int display = (y / PANEL_HEIGHT) * opt.across + (x / PANEL_WIDTH);
+			frame[(size_t)display * PANEL_WIDTH + (x % PANEL_WIDTH)] |= 1 << (y % PANEL_HEIGHT);
+		}
+	}
+	return frame;
+}
+
+static void printFrame(const std::vector<uint8_t>& frame, const Options& opt, size_t index)
+{
+	fprintf(stderr, "frame %u\n", (unsigned)index);
+	for(int y = 0; y < opt.down * PANEL_HEIGHT; ++y)
+	{
+		for(int x = 0; x < opt.across * PANEL_WIDTH; ++x)
+		{
+			int display = (y / PANEL_HEIGHT) * opt.across + (x / PANEL_WIDTH);
+			fputc((frame[(size_t)display * PANEL_WIDTH + (x % PANEL_WIDTH)] >> (y % PANEL_HEIGHT)) & 1 ? '#' : '.', stderr);
+		}
+		fputc('\n', stderr);
+	}
+}
+
+int main(int argc, char** argv)
+{
+	Options opt;
+	opt.across = 1;
+	opt.down = 1;
+	opt.dither = DITHER_FS;
+	opt.level = 128;
+	opt.invert = false;
+	
+	std::string name = "frames";
+	const char* binaryPath = NULL;
+	unsigned threads = std::thread::hardware_concurrency();
+	bool print = false;
+	std::vector<const char*> paths;
+	
+	for(int i = 1; i < argc; ++i)
+	{
+		std::string a = argv[i];
+		bool hasValue = i + 1 < argc;
+		if(a == "-x" && hasValue) opt.across = atoi(argv[++i]);
+		else if(a == "-y" && hasValue) opt.down = atoi(argv[++i]);
+		else if(a == "-t" && hasValue) opt.level = atoi(argv[++i]);
+		else if(a == "-j" && hasValue) threads = atoi(argv[++i]);
+		else if(a == "-b" && hasValue) binaryPath = argv[++i];
+		else if(a == "-n" && hasValue) name = argv[++i];
+		else if(a == "-i") opt.invert = true;
+		else if(a == "-p") print = true;
+		else if(a == "-d" && hasValue)
+		{
+			std::string mode = argv[++i];
+			if(mode == "threshold") opt.dither = DITHER_THRESHOLD;
+			else if(mode == "ordered") opt.dither = DITHER_ORDERED;
+			else if(mode == "fs") opt.dither = DITHER_FS;
+			else fail("dither mode is threshold, ordered or fs");
+		}
+		else if(a[0] != '-') paths.push_back(argv[i]);
+		else fail("unknown option, see the top of imgconv.cpp for usage");
+	}
+	if(paths.empty()) fail("usage: imgconv [-x across] [-y down] [-d threshold|ordered|fs] [-t level] [-i] [-j threads] [-b file] [-n name] [-p] image.ppm ...");
+	if(opt.across <= 0 || opt.down <= 0 || opt.across * opt.down > 32) fail("layout must be 1-32 panels");
+	if(opt.level < 0 || opt.level > 255) fail("level is 0-255");
+	if(threads == 0) threads = 1;
+	
+	std::vector<Image> images;
+	for(size_t i = 0; i < paths.size(); ++i)
+	{
+		std::ifstream in(paths[i], std::ios::binary);
+		if(!in) fail("can't open an input image");
+		std::vector<uint8_t> data((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+		loadImages(data, images);
+	}
+	if(images.empty()) fail("no images");
+	
+	// Frames are independent, workers take the next one until they run out
+	std::vector<std::vector<uint8_t> > frames(images.size());
+	std::atomic<size_t> next(0);
+	std::vector<std::thread> workers;
+	if(threads > images.size()) threads = images.size();
+	for(unsigned t = 0; t < threads; ++t)
+	{
+		workers.push_back(std::thread([&]() {
+			for(size_t i = next++; i < images.size(); i = next++) frames[i] = convert(images[i], opt);
+		}));
+	}
+	for(size_t t = 0; t < workers.size(); ++t) workers[t].join();
+	
+	if(print) for(size_t i = 0; i < frames.size(); ++i) printFrame(frames[i], opt, i);
+	
+	size_t frameSize = frames[0].size();
+	if(binaryPath)
+	{
+		FILE* out = fopen(binaryPath, "wb");
+		if(!out) fail("can't write the output");
+		for(size_t i = 0; i < frames.size(); ++i) fwrite(&frames[i][0], 1, frameSize, out);
+		fclose(out);
+	}
+	else
+	{
+		printf("// Generated by tools/imgconv, %u frames for %dx%d panels (%u bytes each, see MatrixDisplay::syncFrom)\n",
+			(unsigned)frames.size(), opt.across, opt.down, (unsigned)frameSize);
+		printf("#ifndef FRAMES_%s_GUARD\n#define FRAMES_%s_GUARD\n\n", name.c_str(), name.c_str());
+		printf("#include <avr/pgmspace.h>\n\n");
+		printf("#define %s_count %u\n\n", name.c_str(), (unsigned)frames.size());
+		printf("static const uint8_t %s[%u][%u] PROGMEM = {\n", name.c_str(), (unsigned)frames.size(), (unsigned)frameSize);
+		for(size_t f = 0; f < frames.size(); ++f)
+		{
+			printf("\t{");
+			for(size_t i = 0; i < frameSize; ++i) printf("%s0x%02X", (i % 16) ? ", " : (i ? ",\n\t " : " "), frames[f][i]);
+			printf(" }%s\n", f + 1 < frames.size() ? "," : "");
+		}
+		printf("};\n\n#endif\n");
+	}
+	
+	fprintf(stderr, "%s: %u frames, %dx%d panels, %u worker threads\n", name.c_str(), (unsigned)frames.size(),
+		opt.across, opt.down, threads);
+	return 0;
+}
@@ -0,0 +1,106 @@
+/*
+	MatrixDisplay Library 2.0 - imgconv layout check
+	Author: Miles Burton, www.milesburton.com/
+	Copyright (c) 2010 Miles Burton All Rights Reserved
+
+	This library is free software; you can redistribute it and/or
+	modify it under the terms of the GNU Lesser General Public
+	License as published by the Free Software Foundation; either
+	version 2.1 of the License, or (at your option) any later version.
+
+	This library is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+	Lesser General Public License for more details.
+
+	You should have received a copy of the GNU Lesser General Public
+	License along with this library; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+/*
+Checks imgconv's frames against the library: random images are converted by imgconv and the same
+pixels are set with MatrixDisplay::setPixel(), the back buffer has to match the frame byte for byte.
+Covers the byte order of the panels in a layout and the bit order of the rows in a column.
+
+Build:   g++ -std=c++11 -I../hostsim -I../.. -o layoutcheck layoutcheck.cpp ../../MatrixDisplay.cpp ../hostsim/hostsim.cpp
+Usage:   layoutcheck [path to imgconv, default ./imgconv]
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include "MatrixDisplay.h"
+
+#define PANEL_WIDTH  32
+#define PANEL_HEIGHT 8
+
+// Layouts tried, panels across by down
+static const int layouts[][2] = { { 1, 1 }, { 2, 1 }, { 1, 3 }, { 4, 2 }, { 3, 3 } };
+
+int main(int argc, char** argv)
+{
+	std::string imgconv = argc > 1 ? argv[1] : "./imgconv";
+	const char* imagePath = "layoutcheck.pgm";
+	const char* framePath = "layoutcheck.bin";
+	int failures = 0;
+	srand(1632);
+	
+	for(size_t l = 0; l < sizeof(layouts) / sizeof(layouts[0]); ++l)
+	{
+		int across = layouts[l][0];
+		int down = layouts[l][1];
+		int width = across * PANEL_WIDTH;
+		int height = down * PANEL_HEIGHT;
+		
+		// Native size, black or white, so imgconv's threshold mode passes it through untouched
+		std::vector<uint8_t> image((size_t)width * height);
+		for(size_t i = 0; i < image.size(); ++i) image[i] = (rand() & 1) ? 255 : 0;
+		
+		FILE* out = fopen(imagePath, "wb");
+		if(!out) { fprintf(stderr, "layoutcheck: can't write %s\n", imagePath); return 1; }
+		fprintf(out, "P5\n%d %d\n255\n", width, height);
+		fwrite(&image[0], 1, image.size(), out);
+		fclose(out);
+		
+		char command[512];
+		snprintf(command, sizeof(command), "%s -x %d -y %d -d threshold -b %s %s 2>/dev/null",
+			imgconv.c_str(), across, down, framePath, imagePath);
+		if(system(command) != 0) { fprintf(stderr, "layoutcheck: %s failed\n", imgconv.c_str()); return 1; }
+		
+		size_t frameSize = (size_t)across * down * PANEL_WIDTH;
+		std::vector<uint8_t> frame(frameSize);
+		FILE* in = fopen(framePath, "rb");
+		if(!in || fread(&frame[0], 1, frameSize, in) != frameSize) { fprintf(stderr, "layoutcheck: no frame from imgconv\n"); return 1; }
+		fclose(in);
+		
+		// The same pixels through the library, display n is panel (n % across, n / across)
+		MatrixDisplay disp(across * down, 11, 10);
+		for(int y = 0; y < height; ++y)
+		{
+			for(int x = 0; x < width; ++x)
+			{
+				if(!image[(size_t)y * width + x]) continue;
+				int display = (y / PANEL_HEIGHT) * across + (x / PANEL_WIDTH);
+				disp.setPixel(display, x % PANEL_WIDTH, y % PANEL_HEIGHT, 1);
+			}
+		}
+		
+		int mismatches = 0;
+		for(int d = 0; d < across * down; ++d)
+		{
+			const uint8_t* buffer = disp.getBuffer(d);
+			for(int i = 0; i < PANEL_WIDTH; ++i) mismatches += buffer[i] != frame[(size_t)d * PANEL_WIDTH + i];
+		}
+		
+		printf("%dx%d panels: %d bytes differ\n", across, down, mismatches);
+		if(mismatches) ++failures;
+	}
+	
+	remove(imagePath);
+	remove(framePath);
+	printf("%s\n", failures ? "FAILED" : "passed");
+	return failures ? 1 : 0;
+}
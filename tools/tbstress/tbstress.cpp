@@ -0,0 +1,134 @@
+/*
+	MatrixDisplay Library 2.0 - Triple buffer stress test
+	Author: Miles Burton, www.milesburton.com/
+	Copyright (c) 2010 Miles Burton All Rights Reserved
+
+	This library is free software; you can redistribute it and/or
+	modify it under the terms of the GNU Lesser General Public
+	License as published by the Free Software Foundation; either
+	version 2.1 of the License, or (at your option) any later version.
+
+	This library is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+	Lesser General Public License for more details.
+
+	You should have received a copy of the GNU Lesser General Public
+	License along with this library; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+/*
+Host stress test for TripleBuffer's index exchange. A producer thread publishes numbered frames
+flat out while the consumer thread takes them, the way a serial ISR and loop() share one.
+
+The consumer checks every frame it gets is whole (every byte from the same publish, so never torn)
+and newer than the last one it got. It then checks the frame again after the producer has had time
+to publish more, which catches the producer being handed the consumer's frame to write into.
+
+Build:   g++ -O2 -std=c++11 -pthread -I../.. -o tbstress tbstress.cpp ../../TripleBuffer.cpp
+         add -fsanitize=thread -g to run it under ThreadSanitizer as well, which also catches a
+         non-atomic exchange on machines where the threads rarely interleave
+Usage:   tbstress [-n frames] [-s frameSize]
+	-n frames     Frames to publish (default: 1000000)
+	-s frameSize  Bytes per frame (default: 128, four displays)
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <string>
+#include <thread>
+#include <atomic>
+#include "TripleBuffer.h"
+
+static void fail(const char* msg)
+{
+	fprintf(stderr, "tbstress: %s\n", msg);
+	exit(1);
+}
+
+// Frame n holds n in its first 4 bytes and a pattern derived from n in the rest
+static void fillFrame(uint8_t* frame, uint16_t size, uint32_t n)
+{
+	memcpy(frame, &n, sizeof(n));
+	for(uint16_t i = sizeof(n); i < size; ++i) frame[i] = (uint8_t)(n * 31 + i);
+}
+
+static bool frameIsWhole(const uint8_t* frame, uint16_t size, uint32_t* n)
+{
+	memcpy(n, frame, sizeof(*n));
+	for(uint16_t i = sizeof(*n); i < size; ++i)
+	{
+		if(frame[i] != (uint8_t)(*n * 31 + i)) return false;
+	}
+	return true;
+}
+
+int main(int argc, char** argv)
+{
+	uint32_t frames = 1000000;
+	uint16_t frameSize = 128;
+	
+	for(int i = 1; i < argc; ++i)
+	{
+		std::string a = argv[i];
+		bool hasValue = i + 1 < argc;
+		if(a == "-n" && hasValue) frames = strtoul(argv[++i], NULL, 10);
+		else if(a == "-s" && hasValue) frameSize = atoi(argv[++i]);
+		else fail("usage: tbstress [-n frames] [-s frameSize]");
+	}
+	if(frameSize < 8) fail("frames need at least 8 bytes");
+	
+	TripleBuffer tb(frameSize);
+	
+	std::atomic<bool> done(false);
+	
+	std::thread producer([&]() {
+		for(uint32_t n = 1; n <= frames; ++n)
+		{
+			fillFrame(tb.getWriteBuffer(), frameSize, n);
+			tb.publish();
+			
+			// Let the consumer in now and then when both share a core
+			if((n & 0xFF) == 0) std::this_thread::yield();
+		}
+		done = true;
+	});
+	
+	uint32_t taken = 0;
+	uint32_t torn = 0;
+	uint32_t stale = 0;
+	uint32_t overwritten = 0;
+	uint32_t last = 0;
+	for(;;)
+	{
+		// Read done first, a frame published before it was set is still picked up by this pass
+		bool finished = done.load();
+		if(tb.update())
+		{
+			const uint8_t* frame = tb.getReadBuffer();
+			
+			uint32_t n;
+			if(!frameIsWhole(frame, frameSize, &n)) ++torn;
+			else if(n <= last) ++stale;
+			else last = n;
+			++taken;
+			
+			// Still the same frame once the producer has moved on?
+			std::this_thread::yield();
+			uint32_t again;
+			if(!frameIsWhole(frame, frameSize, &again) || again != n) ++overwritten;
+		}
+		else if(finished) break;
+	}
+	producer.join();
+	
+	printf("%u published, %u taken, last %u: %u torn, %u stale, %u overwritten\n",
+		frames, taken, last, torn, stale, overwritten);
+	
+	bool passed = torn == 0 && stale == 0 && overwritten == 0 && last == frames;
+	printf("%s\n", passed ? "passed" : "FAILED");
+	return passed ? 0 : 1;
+}
@@ -0,0 +1,329 @@
+/*
+	MatrixDisplay Library 2.0 - Video wall frame compiler
+	Author: Miles Burton, www.milesburton.com/
+	Copyright (c) 2010 Miles Burton All Rights Reserved
+
+	This library is free software; you can redistribute it and/or
+	modify it under the terms of the GNU Lesser General Public
+	License as published by the Free Software Foundation; either
+	version 2.1 of the License, or (at your option) any later version.
+
+	This library is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+	Lesser General Public License for more details.
+
+	You should have received a copy of the GNU Lesser General Public
+	License along with this library; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+/*
+Host tool for video walls: many HT1632 chains, each driven by its own microcontroller or GPIO bank,
+fed from one Linux box. Frames of a large virtual canvas are split across the chains and compiled
+into per-chain streams which are ready to send, encoded in parallel by a worker pool.
+
+Build:   g++ -O2 -std=c++11 -pthread -o wallc wallc.cpp
+Usage:   wallc -s WxH -c x,y,across,down [-c ...] [options] frames.pgm|frames.raw
+	-s WxH        Canvas size in pixels
+	-c x,y,a,d    A chain covering a panels across by d down, top left panel at canvas pixel (x, y).
+	              Repeat for every chain, numbered in the order given
+	-r            Input is raw 8 bit grey frames (ffmpeg -pix_fmt gray -f rawvideo), not PGM (P5)
+	-t level      Lit threshold, 0-255 (default: 128)
+	-m mode       frame (default) or bits, see below
+	-o prefix     Output files prefix0.bin, prefix1.bin... one per chain (default: chain)
+	-j threads    Worker threads (default: all cores)
+	-B repeat     Benchmark, encode the clip repeat times and report throughput, nothing is written
+
+Stream modes, frames back to back in each chain's file:
+	frame   32 bytes per display in the back buffer layout, display 0 first. Feed it to
+	        MatrixDisplay::syncFrom() on the chain's microcontroller
+	bits    The exact bits each display is clocked in one successive write (ID 101, address 0, then
+	        64 nybbles LSB first, as MatrixDisplay::writeColumns sends them): 266 bits packed MSB first
+	        into 34 bytes per display, the last 6 bits are padding. Clock out 266 with the display's
+	        CS low
+
+Panels within a chain are numbered left to right then top to bottom, as in imgconv. Parts of the
+canvas no chain covers are ignored, panels hanging off the canvas show blank.
+
+wallcheck.cpp checks both modes against the library's back buffer and what it clocks onto the bus.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <string>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+
+// Must match MatrixDisplay / ht1632_cmd.h
+#define PANEL_WIDTH       32
+#define PANEL_HEIGHT      8
+#define PANEL_NIBBLES     64
+#define HT1632_ID_WR      5
+#define BITS_PER_DISPLAY  (3 + 7 + PANEL_NIBBLES * 4)
+#define BYTES_PER_DISPLAY ((BITS_PER_DISPLAY + 7) / 8)
+
+// Frames handed to the workers at a time, bounds the memory used on long clips
+#define BATCH_FRAMES 256
+
+struct Chain
+{
+	int x, y; // Canvas pixel of the top left panel
+	int across, down;
+	int displays() const { return across * down; }
+};
+
+struct Options
+{
+	int width, height;
+	std::vector<Chain> chains;
+	int level;
+	bool bits;
+};
+
+static void fail(const char* msg)
+{
+	fprintf(stderr, "wallc: %s\n", msg);
+	exit(1);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//  ADDRESSING
+//
+// Same mapping as the library's xyToIndex: column x of a display is back buffer byte x, bit y row y
+static inline uint8_t xyToIndex(uint8_t x)
+{
+	return x & 0x1F;
+}
+
+// Bit writer, MSB first
+struct BitWriter
+{
+	uint8_t* out;
+	int bit;
+	BitWriter(uint8_t* _out) : out(_out), bit(0) {}
+	
+	void put(int value)
+	{
+		if(value) out[bit >> 3] |= 0x80 >> (bit & 7);
+		++bit;
+	}
+	// writeDataBE
+	void putBE(int count, uint8_t data) { for(int i = count - 1; i >= 0; --i) put((data >> i) & 1); }
+	// writeDataLE
+	void putLE(int count, uint8_t data) { for(int i = 0; i < count; ++i) put((data >> i) & 1); }
+};
+
+///////////////////////////////////////////////////////////////////////////////
+//  ENCODER
+//
+static size_t chainFrameSize(const Chain& chain, bool bits)
+{
+	return (size_t)chain.displays() * (bits ? BYTES_PER_DISPLAY : PANEL_WIDTH);
+}
+
+// Pack one display's columns straight from the canvas, 8 rows into a byte
+static void packDisplay(const uint8_t* canvas, const Options& opt, int left, int top, uint8_t* columns)
+{
+	for(int x = 0; x < PANEL_WIDTH; ++x)
+	{
+		uint8_t value = 0;
+		int cx = left + x;
+		if(cx >= 0 && cx < opt.width)
+		{
+			for(int y = 0; y < PANEL_HEIGHT; ++y)
+			{
+				int cy = top + y;
+				if(cy >= 0 && cy < opt.height && canvas[(size_t)cy * opt.width + cx] >= opt.level) value |= 1 << y;
+			}
+		}
+		columns[xyToIndex(x)] = value;
+	}
+}
+
+static void encodeChain(const uint8_t* canvas, const Options& opt, const Chain& chain, uint8_t* out)
+{
+	memset(out, 0, chainFrameSize(chain, opt.bits));
+	
+	for(int d = 0; d < chain.displays(); ++d)
+	{
+		int left = chain.x + (d % chain.across) * PANEL_WIDTH;
+		int top = chain.y + (d / chain.across) * PANEL_HEIGHT;
+		
+		if(!opt.bits)
+		{
+			packDisplay(canvas, opt, left, top, out + (size_t)d * PANEL_WIDTH);
+			continue;
+		}
+		
+		uint8_t columns[PANEL_WIDTH];
+		packDisplay(canvas, opt, left, top, columns);
+		
+		// One successive write, as writeColumns(d, 0, 32, columns) clocks it
+		BitWriter w(out + (size_t)d * BYTES_PER_DISPLAY);
+		w.putBE(3, HT1632_ID_WR);
+		w.putBE(7, 0);
+		for(int x = 0; x < PANEL_WIDTH; ++x) w.putLE(8, columns[x]);
+	}
+}
+
+// Every (frame, chain) pair of the batch is a job, workers take the next one until they run out
+static void encodeBatch(const std::vector<uint8_t>& canvases, size_t frameCount, const Options& opt,
+						const std::vector<size_t>& chainOffsets, size_t frameStride, std::vector<uint8_t>& out, unsigned threads)
+{
+	size_t canvasSize = (size_t)opt.width * opt.height;
+	size_t jobs = frameCount * opt.chains.size();
+	std::atomic<size_t> next(0);
+	
+	std::vector<std::thread> workers;
+	for(unsigned t = 0; t < threads; ++t)
+	{
+		workers.push_back(std::thread([&]() {
+			for(size_t job = next++; job < jobs; job = next++)
+			{
+				size_t frame = job / opt.chains.size();
+				size_t chain = job % opt.chains.size();
+				encodeChain(&canvases[frame * canvasSize], opt, opt.chains[chain], &out[frame * frameStride + chainOffsets[chain]]);
+			}
+		}));
+	}
+	for(size_t t = 0; t < workers.size(); ++t) workers[t].join();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//  INPUT
+//
+// Next frame from a raw or P5 stream, false at the end
+static bool readFrame(FILE* in, const Options& opt, bool raw, uint8_t* canvas)
+{
+	if(!raw)
+	{
+		int w, h, maxValue;
+		if(fscanf(in, " P5 %d %d %d", &w, &h, &maxValue) != 3) return false;
+		fgetc(in); // Single whitespace before the raster
+		if(w != opt.width || h != opt.height) fail("PGM frame isn't the canvas size");
+		if(maxValue > 255) fail("16 bit PGM isn't supported");
+	}
+	
+	size_t size = (size_t)opt.width * opt.height;
+	size_t got = fread(canvas, 1, size, in);
+	if(got == 0) return false;
+	if(got != size) fail("last frame is cut short");
+	return true;
+}
+
+int main(int argc, char** argv)
+{
+	Options opt;
+	opt.width = opt.height = 0;
+	opt.level = 128;
+	opt.bits = false;
+	
+	std::string prefix = "chain";
+	unsigned threads = std::thread::hardware_concurrency();
+	int benchmark = 0;
+	bool raw = false;
+	const char* path = NULL;
+	
+	for(int i = 1; i < argc; ++i)
+	{
+		std::string a = argv[i];
+		bool hasValue = i + 1 < argc;
+		if(a == "-s" && hasValue)
+		{
+			if(sscanf(argv[++i], "%dx%d", &opt.width, &opt.height) != 2) fail("canvas size is WxH");
+		}
+		else if(a == "-c" && hasValue)
+		{
+			Chain chain;
+			if(sscanf(argv[++i], "%d,%d,%d,%d", &chain.x, &chain.y, &chain.across, &chain.down) != 4) fail("chain is x,y,across,down");
+			if(chain.across <= 0 || chain.down <= 0 || chain.displays() > 32) fail("a chain is 1-32 panels");
+			opt.chains.push_back(chain);
+		}
+		else if(a == "-t" && hasValue) opt.level = atoi(argv[++i]);
+		else if(a == "-m" && hasValue)
+		{
+			std::string mode = argv[++i];
+			if(mode == "bits") opt.bits = true;
+			else if(mode != "frame") fail("mode is frame or bits");
+		}
+		else if(a == "-o" && hasValue) prefix = argv[++i];
+		else if(a == "-j" && hasValue) threads = atoi(argv[++i]);
+		else if(a == "-B" && hasValue) benchmark = atoi(argv[++i]);
+		else if(a == "-r") raw = true;
+		else if(a[0] != '-') path = argv[i];
+		else fail("unknown option, see the top of wallc.cpp for usage");
+	}
+	if(opt.width <= 0 || opt.height <= 0 || opt.chains.empty()) fail("usage: wallc -s WxH -c x,y,across,down [-c ...] [-r] [-t level] [-m frame|bits] [-o prefix] [-j threads] [-B repeat] frames");
+	if(threads == 0) threads = 1;
+	if(!path) fail("no input");
+	
+	FILE* in = fopen(path, "rb");
+	if(!in) fail("can't open the input");
+	
+	// Where each chain's part of an encoded frame starts
+	std::vector<size_t> chainOffsets;
+	size_t frameStride = 0;
+	for(size_t c = 0; c < opt.chains.size(); ++c)
+	{
+		chainOffsets.push_back(frameStride);
+		frameStride += chainFrameSize(opt.chains[c], opt.bits);
+	}
+	
+	std::vector<FILE*> outputs;
+	if(!benchmark)
+	{
+		for(size_t c = 0; c < opt.chains.size(); ++c)
+		{
+			std::string name = prefix + std::to_string(c) + ".bin";
+			FILE* out = fopen(name.c_str(), "wb");
+			if(!out) fail("can't write an output");
+			outputs.push_back(out);
+		}
+	}
+	
+	size_t canvasSize = (size_t)opt.width * opt.height;
+	std::vector<uint8_t> canvases(canvasSize * BATCH_FRAMES);
+	std::vector<uint8_t> encoded(frameStride * BATCH_FRAMES);
+	size_t totalFrames = 0;
+	double encodeSeconds = 0;
+	
+	for(;;)
+	{
+		size_t frameCount = 0;
+		while(frameCount < BATCH_FRAMES && readFrame(in, opt, raw, &canvases[frameCount * canvasSize])) ++frameCount;
+		if(frameCount == 0) break;
+		
+		int repeats = benchmark ? benchmark : 1;
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		for(int r = 0; r < repeats; ++r) encodeBatch(canvases, frameCount, opt, chainOffsets, frameStride, encoded, threads);
+		encodeSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		totalFrames += frameCount * repeats;
+		
+		for(size_t c = 0; c < outputs.size(); ++c)
+		{
+			size_t size = chainFrameSize(opt.chains[c], opt.bits);
+			for(size_t f = 0; f < frameCount; ++f) fwrite(&encoded[f * frameStride + chainOffsets[c]], 1, size, outputs[c]);
+		}
+	}
+	fclose(in);
+	for(size_t c = 0; c < outputs.size(); ++c) fclose(outputs[c]);
+	
+	size_t panels = 0;
+	for(size_t c = 0; c < opt.chains.size(); ++c) panels += opt.chains[c].displays();
+	double pixels = (double)totalFrames * panels * PANEL_WIDTH * PANEL_HEIGHT;
+	
+	fprintf(stderr, "%u frames, %u chains, %u panels, %u worker threads\n", (unsigned)totalFrames,
+		(unsigned)opt.chains.size(), (unsigned)panels, threads);
+	if(encodeSeconds > 0)
+	{
+		fprintf(stderr, "encode: %.3fs, %.0f frames/s, %.1f Mpixels/s\n", encodeSeconds,
+			totalFrames / encodeSeconds, pixels / encodeSeconds / 1e6);
+	}
+	return 0;
+}
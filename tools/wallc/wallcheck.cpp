@@ -0,0 +1,164 @@
+/*
+	MatrixDisplay Library 2.0 - wallc check
+	Author: Miles Burton, www.milesburton.com/
+	Copyright (c) 2010 Miles Burton All Rights Reserved
+
+	This library is free software; you can redistribute it and/or
+	modify it under the terms of the GNU Lesser General Public
+	License as published by the Free Software Foundation; either
+	version 2.1 of the License, or (at your option) any later version.
+
+	This library is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+	Lesser General Public License for more details.
+
+	You should have received a copy of the GNU Lesser General Public
+	License along with this library; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+/*
+Checks wallc against the library. A random clip is compiled by wallc in both modes, then every
+chain's panels are drawn with MatrixDisplay::setPixel() and sent with syncDisplays() on the host
+simulator (tools/hostsim):
+	frame   has to match the back buffer byte for byte
+	bits    has to match the bits each display's CS saw clocked in, bit for bit
+
+Build:   g++ -std=c++11 -I../hostsim -I../.. -o wallcheck wallcheck.cpp ../../MatrixDisplay.cpp ../hostsim/hostsim.cpp
+Usage:   wallcheck [path to wallc, default ./wallc]
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include "MatrixDisplay.h"
+#include "hostsim.h"
+
+#define PANEL_WIDTH       32
+#define PANEL_HEIGHT      8
+#define BYTES_PER_DISPLAY 34 // 266 bits, see wallc.cpp
+
+#define CLIP_WIDTH  160
+#define CLIP_HEIGHT 24
+#define CLIP_FRAMES 6
+
+// Chains tried, x, y, across, down. Some hang off the canvas
+static const int chains[][4] = { { 0, 0, 4, 2 }, { 96, 8, 2, 3 }, { -16, 4, 3, 1 }, { 150, 20, 1, 1 } };
+#define CHAIN_COUNT (int)(sizeof(chains) / sizeof(chains[0]))
+
+// CS pins for up to 8 displays, clear of the clock (11) and data (10) pins
+static const uint8_t csPins[] = { 2, 3, 4, 5, 6, 7, 8, 9 };
+
+static bool readFile(const std::string& path, std::vector<uint8_t>& data)
+{
+	FILE* in = fopen(path.c_str(), "rb");
+	if(!in) return false;
+	int c;
+	while((c = fgetc(in)) != EOF) data.push_back((uint8_t)c);
+	fclose(in);
+	return true;
+}
+
+static void runWallc(const std::string& wallc, const char* mode, const char* prefix, const char* clipPath)
+{
+	std::string command = wallc + " -s " + std::to_string(CLIP_WIDTH) + "x" + std::to_string(CLIP_HEIGHT) + " -r -m " + mode + " -o " + prefix;
+	for(int c = 0; c < CHAIN_COUNT; ++c)
+	{
+		command += " -c " + std::to_string(chains[c][0]) + "," + std::to_string(chains[c][1]) + "," +
+			std::to_string(chains[c][2]) + "," + std::to_string(chains[c][3]);
+	}
+	command += std::string(" ") + clipPath + " 2>/dev/null";
+	
+	if(system(command.c_str()) != 0)
+	{
+		fprintf(stderr, "wallcheck: %s failed\n", wallc.c_str());
+		exit(1);
+	}
+}
+
+int main(int argc, char** argv)
+{
+	std::string wallc = argc > 1 ? argv[1] : "./wallc";
+	const char* clipPath = "wallcheck.raw";
+	srand(1632);
+	
+	// Black and white so the threshold can't matter
+	std::vector<uint8_t> clip((size_t)CLIP_WIDTH * CLIP_HEIGHT * CLIP_FRAMES);
+	for(size_t i = 0; i < clip.size(); ++i) clip[i] = (rand() & 1) ? 255 : 0;
+	FILE* out = fopen(clipPath, "wb");
+	if(!out) { fprintf(stderr, "wallcheck: can't write %s\n", clipPath); return 1; }
+	fwrite(&clip[0], 1, clip.size(), out);
+	fclose(out);
+	
+	runWallc(wallc, "frame", "wallcheck_frame", clipPath);
+	runWallc(wallc, "bits", "wallcheck_bits", clipPath);
+	
+	int byteMismatches = 0;
+	int bitMismatches = 0;
+	for(int c = 0; c < CHAIN_COUNT; ++c)
+	{
+		std::string frameFile = "wallcheck_frame" + std::to_string(c) + ".bin";
+		std::string bitsFile = "wallcheck_bits" + std::to_string(c) + ".bin";
+		std::vector<uint8_t> frames, bits;
+		if(!readFile(frameFile, frames) || !readFile(bitsFile, bits)) { fprintf(stderr, "wallcheck: no output from wallc\n"); return 1; }
+		remove(frameFile.c_str());
+		remove(bitsFile.c_str());
+		
+		int across = chains[c][2];
+		int displays = across * chains[c][3];
+		if(frames.size() != (size_t)displays * PANEL_WIDTH * CLIP_FRAMES || bits.size() != (size_t)displays * BYTES_PER_DISPLAY * CLIP_FRAMES)
+		{
+			fprintf(stderr, "wallcheck: chain %d output is the wrong size\n", c);
+			return 1;
+		}
+		
+		for(int f = 0; f < CLIP_FRAMES; ++f)
+		{
+			MatrixDisplay disp(displays, 11, 10);
+			disp.initDisplays(csPins, 0);
+			
+			for(int d = 0; d < displays; ++d)
+			{
+				for(int y = 0; y < PANEL_HEIGHT; ++y)
+				{
+					for(int x = 0; x < PANEL_WIDTH; ++x)
+					{
+						int cx = chains[c][0] + (d % across) * PANEL_WIDTH + x;
+						int cy = chains[c][1] + (d / across) * PANEL_HEIGHT + y;
+						if(cx < 0 || cy < 0 || cx >= CLIP_WIDTH || cy >= CLIP_HEIGHT) continue;
+						if(clip[((size_t)f * CLIP_HEIGHT + cy) * CLIP_WIDTH + cx]) disp.setPixel(d, x, y, 1);
+					}
+				}
+			}
+			
+			hostsimWatchBus(11, 10);
+			disp.syncDisplays();
+			
+			for(int d = 0; d < displays; ++d)
+			{
+				const uint8_t* buffer = disp.getBuffer(d);
+				const uint8_t* frame = &frames[((size_t)f * displays + d) * PANEL_WIDTH];
+				for(int i = 0; i < PANEL_WIDTH; ++i) byteMismatches += buffer[i] != frame[i];
+				
+				const std::vector<uint8_t>& sent = hostsimBusBits(csPins[d]);
+				const uint8_t* packed = &bits[((size_t)f * displays + d) * BYTES_PER_DISPLAY];
+				if(sent.size() + 6 != BYTES_PER_DISPLAY * 8)
+				{
+					++bitMismatches;
+					continue;
+				}
+				for(size_t i = 0; i < sent.size(); ++i) bitMismatches += sent[i] != ((packed[i >> 3] >> (7 - (i & 7))) & 1);
+			}
+		}
+		
+		printf("chain %d (%dx%d panels): %d bytes, %d bits differ so far\n", c, across, chains[c][3], byteMismatches, bitMismatches);
+	}
+	
+	remove(clipPath);
+	bool passed = byteMismatches == 0 && bitMismatches == 0;
+	printf("%s\n", passed ? "passed" : "FAILED");
+	return passed ? 0 : 1;
+}